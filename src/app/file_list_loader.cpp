@@ -0,0 +1,147 @@
+//@	{"target": {"name":"file_list_loader.o"}}
+
+#include "./file_list_loader.hpp"
+
+#include "src/file_collector/binary_file_list.hpp"
+#include "src/file_collector/json_file_list.hpp"
+#include "src/utils/mapped_file.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	constexpr size_t first_binary_batch_size = 16;
+	constexpr size_t max_binary_batch_size = 65536;
+}
+
+slideproj::app::file_list_loader::file_list_loader(std::filesystem::path const& src)
+{
+	auto data = std::make_shared<utils::mapped_file const>(src);
+	if(file_collector::is_binary_file_list(data->data()))
+	{
+		// NOTE: Only the header is read here. Entries are appended in batches of increasing size by
+		//       the worker, so the slideshow can start before the whole offset table has been read.
+		file_collector::binary_file_list_view const binary_file_list{data->data()};
+		m_jobinfo = nlohmann::json::parse(binary_file_list.jobinfo());
+		m_worker = std::jthread{
+			[this, data = std::move(data), binary_file_list](std::stop_token stop_token){
+				std::exception_ptr error;
+				try
+				{
+					size_t batch_begin = 0;
+					auto batch_size = first_binary_batch_size;
+					while(batch_begin < std::size(binary_file_list) && !stop_token.stop_requested())
+					{
+						// NOTE: Paths are not copied out of the file, so it has to be kept open
+						auto const batch_end = batch_begin + batch_size;
+						file_collector::file_list batch;
+						binary_file_list.append_entries(batch, batch_begin, batch_end);
+						batch.keep_alive(data);
+						append(std::move(batch));
+						batch_begin = batch_end;
+						batch_size = std::min(2*batch_size, max_binary_batch_size);
+					}
+				}
+				catch(...)
+				{ error = std::current_exception(); }
+				finish(error);
+			}
+		};
+		return;
+	}
+
+	m_worker = std::jthread{
+		[this, data = std::move(data)](std::stop_token stop_token){
+			struct loader_ref
+			{
+				file_list_loader* self;
+				std::stop_token stop_token;
+			};
+
+			loader_ref consumer{this, std::move(stop_token)};
+			std::exception_ptr error;
+			try
+			{
+				file_collector::load_json_file_list(
+					data->data(),
+					file_collector::type_erased_json_file_list_consumer{
+						.object = &consumer,
+						.set_jobinfo = [](void* object, nlohmann::json&& jobinfo) {
+							static_cast<loader_ref*>(object)->self->set_jobinfo(std::move(jobinfo));
+						},
+						.append = [](void* object, file_collector::file_list&& files) {
+							auto const obj = static_cast<loader_ref*>(object);
+							obj->self->append(std::move(files));
+							return !obj->stop_token.stop_requested();
+						}
+					}
+				);
+			}
+			catch(...)
+			{ error = std::current_exception(); }
+			finish(error);
+		}
+	};
+}
+
+nlohmann::json const& slideproj::app::file_list_loader::wait_for_jobinfo()
+{
+	std::unique_lock lock{m_mutex};
+	m_cv.wait(lock, [this](){ return m_jobinfo.has_value() || m_done; });
+	rethrow_error();
+	if(!m_jobinfo.has_value())
+	{ throw std::runtime_error{"Missing slideproj jobinfo"}; }
+	return *m_jobinfo;
+}
+
+void slideproj::app::file_list_loader::wait_for_entries(size_t count)
+{
+	std::unique_lock lock{m_mutex};
+	m_cv.wait(lock, [this, count](){ return m_loaded_count >= count || m_done; });
+	rethrow_error();
+}
+
+slideproj::file_collector::file_list slideproj::app::file_list_loader::take_loaded_entries()
+{
+	std::lock_guard lock{m_mutex};
+	rethrow_error();
+	return std::exchange(m_loaded_entries, file_collector::file_list{});
+}
+
+bool slideproj::app::file_list_loader::is_done() const
+{
+	std::lock_guard lock{m_mutex};
+	return m_done;
+}
+
+void slideproj::app::file_list_loader::set_jobinfo(nlohmann::json&& jobinfo)
+{
+	std::lock_guard lock{m_mutex};
+	m_jobinfo = std::move(jobinfo);
+	m_cv.notify_all();
+}
+
+void slideproj::app::file_list_loader::append(file_collector::file_list&& files)
+{
+	std::lock_guard lock{m_mutex};
+	m_loaded_count += std::size(files);
+	m_loaded_entries.append(std::move(files));
+	m_cv.notify_all();
+}
+
+void slideproj::app::file_list_loader::finish(std::exception_ptr error)
+{
+	std::lock_guard lock{m_mutex};
+	m_error = error;
+	m_done = true;
+	m_cv.notify_all();
+}
+
+void slideproj::app::file_list_loader::rethrow_error() const
+{
+	if(m_error)
+	{ std::rethrow_exception(m_error); }
+}
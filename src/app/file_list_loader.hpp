@@ -0,0 +1,60 @@
+//@	{"dependencies_extra":[{"ref":"./file_list_loader.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_APP_FILE_LIST_LOADER_HPP
+#define SLIDEPROJ_APP_FILE_LIST_LOADER_HPP
+
+#include "src/file_collector/file_collector.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <thread>
+
+namespace slideproj::app
+{
+	// Loads a file list in the background, so a slideshow can start before all entries are known.
+	// Binary file lists need no parsing, but their entries are also appended in the background.
+	//
+	// NOTE: Errors from the loader are rethrown by the member functions below
+	class file_list_loader
+	{
+	public:
+		explicit file_list_loader(std::filesystem::path const& src);
+
+		// NOTE: The returned object stays valid for the lifetime of the loader
+		nlohmann::json const& wait_for_jobinfo();
+
+		// Blocks until count entries have been loaded, or the whole list has been loaded
+		void wait_for_entries(size_t count);
+
+		// Returns entries loaded since the previous call
+		file_collector::file_list take_loaded_entries();
+
+		bool is_done() const;
+
+	private:
+		void set_jobinfo(nlohmann::json&& jobinfo);
+
+		void append(file_collector::file_list&& files);
+
+		void finish(std::exception_ptr error);
+
+		void rethrow_error() const;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::optional<nlohmann::json> m_jobinfo;
+		file_collector::file_list m_loaded_entries;
+		size_t m_loaded_count{0};
+		bool m_done{false};
+		std::exception_ptr m_error;
+
+		// NOTE: Must be the last member, so it is joined before the state above is destroyed
+		std::jthread m_worker;
+	};
+}
+
+#endif
@@ -1,10 +1,12 @@
 #ifndef SLIDEPROJ_APP_INPUT_FILTER_HPP
 #define SLIDEPROJ_APP_INPUT_FILTER_HPP
 
+#include "src/file_collector/file_collector.hpp"
 #include "src/utils/unwrap.hpp"
 #include "src/utils/glob_string.hpp"
 
 #include <filesystem>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <utility>
@@ -14,19 +16,29 @@ namespace slideproj::app
 	template<class ImageDimensionProvider>
 	struct input_filter
 	{
-		bool accepts(std::filesystem::directory_entry const& entry) const
+		bool may_accept(std::string_view path) const
 		{
-			if(std::ranges::any_of(include, [path = entry.path().string()](auto const& pattern) {
+			return std::ranges::any_of(include, [path](auto const& pattern) {
 				return pattern.matches(path);
-			}))
-			{
-				auto const dimensions = std::as_const(utils::unwrap(image_dimension_provider))
-					.get_dimensions(entry.path());
-				auto const w = static_cast<size_t>(dimensions.width);
-				auto const h = static_cast<size_t>(dimensions.height);
-				auto const img_pixel_count = w*h;
-				return img_pixel_count > static_cast<size_t>(0) && img_pixel_count <= max_pixel_count;
-			}
+			});
+		}
+
+		// NOTE: make_file_list only calls accepts for paths that have passed may_accept
+		bool accepts(file_collector::scanned_file const& item) const
+		{
+			auto const& provider = std::as_const(utils::unwrap(image_dimension_provider));
+			std::filesystem::path const path{item.path};
+			auto const dimensions = provider.get_dimensions(path);
+			auto const w = static_cast<size_t>(dimensions.width);
+			auto const h = static_cast<size_t>(dimensions.height);
+			auto const img_pixel_count = w*h;
+			if(img_pixel_count > static_cast<size_t>(0) && img_pixel_count <= max_pixel_count)
+			{ return true; }
+
+			// NOTE: A provider may keep data about the file until it is asked for its metadata. That
+			//       never happens for a rejected file.
+			if constexpr(requires{ provider.discard_header(path); })
+			{ provider.discard_header(path); }
 			return false;
 		}
 
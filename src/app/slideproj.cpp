@@ -5,13 +5,17 @@
 #include "./slideshow_playback_controller.hpp"
 #include "./slideshow.hpp"
 #include "./slideshow_presentation_controller.hpp"
+#include "./file_list_loader.hpp"
 
 #include "src/config/user_dir_provider.hpp"
 #include "src/pixel_store/rgba_image.hpp"
+#include "src/pixel_store/pixel_buffer_pool.hpp"
 #include "src/file_collector/file_collector.hpp"
+#include "src/file_collector/binary_file_list.hpp"
 #include "src/image_file_loader/image_file_loader.hpp"
 #include "src/glfw_wrapper/glfw_wrapper.hpp"
 #include "src/utils/task_queue.hpp"
+#include "src/utils/thread_pool.hpp"
 #include "src/utils/task_result_queue.hpp"
 #include "src/renderer/image_display.hpp"
 #include "src/utils/transparent_string_hash.hpp"
@@ -20,6 +24,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <thread>
 #include <nlohmann/adl_serializer.hpp>
 #include <nlohmann/detail/output/serializer.hpp>
 #include <nlohmann/json.hpp>
@@ -28,7 +33,9 @@
 int create_file_list(slideproj::utils::string_lookup_table<std::vector<std::string>> const& args)
 {
 	fprintf(stderr, "(i) Creating list of files\n");
-	slideproj::image_file_loader::image_file_metadata_repository metadata_repo;
+	std::filesystem::path const scan_index_file{args.at("scan-index-file").at(0)};
+	slideproj::image_file_loader::image_file_index scan_index{scan_index_file};
+	slideproj::image_file_loader::image_file_metadata_repository metadata_repo{scan_index};
 	auto const maxnum_pixels = slideproj::utils::to_number(
 		args.at("max-pixel-count").at(0),
 		std::ranges::minmax_result{1U, 1'073'741'824U}
@@ -36,6 +43,13 @@ int create_file_list(slideproj::utils::string_lookup_table<std::vector<std::stri
 	if(!maxnum_pixels.has_value())
 	{ throw std::runtime_error{"Invalid value for max-pixel-count. Value should be within 1 and 2^30."}; }
 
+	auto const scan_threads = slideproj::utils::to_number(
+		args.at("scan-threads").at(0),
+		std::ranges::minmax_result{static_cast<size_t>(1), static_cast<size_t>(1024)}
+	);
+	if(!scan_threads.has_value())
+	{ throw std::runtime_error{"Invalid value for scan-threads. Value should be within 1 and 1024."}; }
+
 	auto const file_list = slideproj::file_collector::make_file_list(
 		args.at("scan-directories"),
 		slideproj::app::input_filter{
@@ -45,31 +59,51 @@ int create_file_list(slideproj::utils::string_lookup_table<std::vector<std::stri
 			},
 		slideproj::file_collector::make_metadata_field_array(args.at("order-by")),
 		metadata_repo,
-		[](auto const& a, auto const& b) {
-			auto const res = strcoll(a.c_str(), b.c_str());
-			if(res < 0)
-			{ return std::strong_ordering::less; }
-			if(res == 0)
-			{ return std::strong_ordering::equal; }
-			return std::strong_ordering::greater;
-		}
+		[](std::string const& str) {
+			return slideproj::file_collector::make_locale_collation_key(str);
+		},
+		*scan_threads
 	);
 
 	fprintf(stderr, "(i) Collected %zu files\n", file_list.size());
 
-	nlohmann::json to_serialize;
+	if(!scan_index_file.empty())
+	{
+		try
+		{ scan_index.save(scan_index_file); }
+		catch(std::exception const& err)
+		{ fprintf(stderr, "(!) %s\n", err.what()); }
+	}
+
+	auto const working_directory = std::filesystem::current_path();
 	nlohmann::json slideproj_create_opts;
 	slideproj_create_opts.emplace("max_pixel_count", *maxnum_pixels);
 	slideproj_create_opts.emplace("order_by", args.at("order-by"));
 	slideproj_create_opts.emplace("include", args.at("include"));
 	slideproj_create_opts.emplace("scan_directories", args.at("scan-directories"));
-	slideproj_create_opts.emplace("working_directory", std::filesystem::current_path());
+	slideproj_create_opts.emplace("working_directory", working_directory);
+
+	if(args.at("output-format").at(0) == "binary")
+	{
+		std::ofstream output{args.at("output-file").at(0), std::ios::binary};
+		slideproj::file_collector::write_binary_file_list(
+			output,
+			slideproj_create_opts.dump(),
+			file_list,
+			working_directory
+		);
+		return 0;
+	}
+
+	// NOTE: The jobinfo is written before the files, so a reader can resolve paths while it streams
+	//       through the list
+	nlohmann::ordered_json to_serialize;
 	to_serialize.emplace("slideproj_create_jobinfo", std::move(slideproj_create_opts));
 
-	nlohmann::json serialized_file_list;
+	nlohmann::ordered_json serialized_file_list;
 	for(auto const& item : file_list)
 	{
-		nlohmann::json entry;
+		nlohmann::ordered_json entry;
 		entry.emplace("path", item.path());
 		serialized_file_list.push_back(std::move(entry));
 	}
@@ -273,57 +307,26 @@ void set_start_index(
 }
 
 
-int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string>> const& args)
+// Forwards task results to the main loop, and wakes it up so the results are processed without
+// delay
+struct main_loop_waking_result_queue
 {
-	nlohmann::json serialized_file_list;
-	{
-		std::ifstream input{args.at("file").at(0)};
-		if(!input.is_open())
-		{ throw std::runtime_error{std::format("Error while trying to open file list: {}", strerror(errno))}; }
-		input >> serialized_file_list;
-	}
-
-	auto const jobinfo = serialized_file_list.find("slideproj_create_jobinfo");
-
-	if(jobinfo == std::end(serialized_file_list))
-	{ throw std::runtime_error{"Missing slideproj jobinfo"}; }
+	std::reference_wrapper<slideproj::utils::task_result_queue> results;
 
-	auto const wdi = jobinfo->find("working_directory");
-	if(wdi == std::end(*jobinfo))
-	{ throw std::runtime_error{"Field working_directory is missing from jobinfo"}; }
-
-	auto const working_directory_ptr = wdi->get_ptr<nlohmann::json::string_t const*>();
-	if(working_directory_ptr == nullptr)
-	{ throw std::runtime_error{"Field working_directory must be a string"}; }
-
-	std::filesystem::path const working_directory{*working_directory_ptr};
-
-	auto const i = serialized_file_list.find("files");
-	if(i == std::end(serialized_file_list))
-	{ throw std::runtime_error{"No file list present in the input"}; }
-	if(!i->is_array())
-	{ throw std::runtime_error{"The list of files should be an array"}; }
-
-	slideproj::file_collector::file_list file_list;
-	for(auto const& item: *i)
+	void push(slideproj::utils::task_completion_handler&& obj)
 	{
-		auto const j = item.find("path");
-		if(j == std::end(item))
-		{ continue; }
-
-		auto str = j->get_ptr<nlohmann::json::string_t const*>();
-		if(str == nullptr)
-		{ continue; }
-
-		file_list.append(canonical(working_directory/(*str)));
+		slideproj::utils::unwrap(results).push(std::move(obj));
+		slideproj::glfw_wrapper::glfw_window::post_empty_event();
 	}
-	fprintf(stderr, "(i) Loaded file list\n");
 
-	if(file_list.empty())
-	{
-		fprintf(stderr, "(!) File list is empty. Exiting.\n");
-		return 0;
-	}
+	void clear()
+	{ slideproj::utils::unwrap(results).clear(); }
+};
+
+int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string>> const& args)
+{
+	slideproj::app::file_list_loader file_list_loader{args.at("file").at(0)};
+	auto const& jobinfo = file_list_loader.wait_for_jobinfo();
 
 	auto const step_delay = slideproj::utils::to_number(
 		args.at("step-delay").at(0),
@@ -341,6 +344,26 @@ int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string
 	if(!transition_duration.has_value())
 	{ throw std::runtime_error{"Invalid value for transition-duration. Value should be within 0.03125 and 8."}; }
 
+	auto const loader_threads = slideproj::utils::to_number(
+		args.at("loader-threads").at(0),
+		std::ranges::minmax_result{static_cast<size_t>(1), static_cast<size_t>(64)}
+	);
+	if(!loader_threads.has_value())
+	{ throw std::runtime_error{"Invalid value for loader-threads. Value should be within 1 and 64."}; }
+
+	auto const pixel_cache_size = slideproj::utils::to_number(
+		args.at("pixel-cache-size").at(0),
+		std::ranges::minmax_result{static_cast<size_t>(0), static_cast<size_t>(1048576)}
+	);
+	if(!pixel_cache_size.has_value())
+	{ throw std::runtime_error{"Invalid value for pixel-cache-size. Value should be within 0 and 1048576."}; }
+
+	auto& pixel_buffers = slideproj::pixel_store::get_default_pixel_buffer_pool();
+	pixel_buffers.set_params(slideproj::pixel_store::pixel_buffer_pool_descriptor{
+		.max_cached_bytes = *pixel_cache_size << 20,
+		.use_huge_pages = (args.at("huge-pages").at(0) == "yes")
+	});
+
 	auto const& loop_str = args.at("loop").at(0);
 	auto const& fullscreen_str = args.at("fullscreen").at(0);
 	auto const& hide_cursor_str = args.at("hide-cursor").at(0);
@@ -350,10 +373,23 @@ int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string
 	auto const savestate_dir = slideproj::config::get_user_dirs().savestates;
 	auto statefile = load_statefile(savestate_dir);
 
-	auto const start_at = get_start_index(statefile, *jobinfo, fullpath, args);
+	auto const start_at = get_start_index(statefile, jobinfo, fullpath, args);
 	if(!start_at.has_value())
 	{ throw std::runtime_error{"Invalid value for start-at"}; }
 
+	// NOTE: The slideshow can start as soon as the first image and its prefetch neighbours are known.
+	//       The rest of the list is appended while the slideshow is running.
+	file_list_loader.wait_for_entries(static_cast<size_t>(*start_at) + 4);
+	auto file_list = file_list_loader.take_loaded_entries();
+	if(file_list.empty())
+	{
+		fprintf(stderr, "(!) File list is empty. Exiting.\n");
+		return 0;
+	}
+	auto file_list_loaded = file_list_loader.is_done();
+	if(file_list_loaded)
+	{ fprintf(stderr, "(i) Loaded file list\n"); }
+
 	auto main_window = slideproj::glfw_wrapper::glfw_window::create("slideproj");
 
 	fprintf(
@@ -379,6 +415,7 @@ int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string
 
 	slideproj::app::slideshow slideshow{std::move(file_list)};
 	slideproj::utils::task_result_queue task_results;
+	main_loop_waking_result_queue task_result_sink{task_results};
 	slideproj::renderer::image_display img_display{};
 	slideproj::image_file_loader::image_file_metadata_repository metadata_repo;
 	slideproj::app::slideshow_playback_controller playback_ctrl{
@@ -390,9 +427,13 @@ int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string
 		}
 	};
 
-	slideproj::utils::task_queue pending_tasks{task_results};
+	// NOTE: The loader threads take part in the row work of their own images, so one thread less is
+	//       needed
+	slideproj::utils::thread_pool pixel_workers{std::max(std::thread::hardware_concurrency(), 2u) - 1};
+	slideproj::utils::task_queue pending_tasks{task_result_sink, *loader_threads};
 	slideproj::app::slideshow_presentation_controller slideshow_presentation_controller{
 		pending_tasks,
+		pixel_workers,
 		img_display,
 		*main_window,
 		std::cref(metadata_repo),
@@ -401,7 +442,8 @@ int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string
 			.transition_duration = std::chrono::duration_cast<slideproj::app::slideshow_clock::duration>(
 				std::chrono::duration<float>{*transition_duration}
 			),
-			.loop = (loop_str == "yes")
+			.loop = (loop_str == "yes"),
+			.log_load_times = (args.at("log-load-times").at(0) == "yes")
 		}
 	};
 	slideproj::app::slideshow_window_event_handler eh{
@@ -416,18 +458,60 @@ int show_file_list(slideproj::utils::string_lookup_table<std::vector<std::string
 	while(!eh.application_should_exit())
 	{
 		auto const now = std::chrono::steady_clock::now();
-		task_results.drain();
+		// NOTE: Completion handlers may upload textures. Leave the rest of the frame for rendering,
+		//       and continue with remaining results in the next frame.
+		auto const results_left = task_results.drain(std::chrono::milliseconds{4});
+
+		if(!file_list_loaded)
+		{
+			file_list_loaded = file_list_loader.is_done();
+			slideshow.append(file_list_loader.take_loaded_entries());
+			slideshow_presentation_controller.handle_appended_entries();
+			if(file_list_loaded)
+			{ fprintf(stderr, "(i) Loaded file list\n"); }
+		}
 
 		slideshow_presentation_controller.update_clock(now);
 
-		main_window->poll_events();
-		glClear(GL_COLOR_BUFFER_BIT);
-		img_display.update();
-		main_window->swap_buffers();
+		if(eh.take_window_damage() || img_display.needs_redraw())
+		{
+			glClear(GL_COLOR_BUFFER_BIT);
+			img_display.update();
+			main_window->swap_buffers();
+		}
+
+		// NOTE: While a transition is running, frames are paced by swap_buffers. Otherwise, sleep until
+		//       the next step, or until a task has completed. The file list loader cannot wake up the
+		//       main loop, so check it regularly while it is running.
+		if(results_left || slideshow_presentation_controller.transition_is_running())
+		{ main_window->poll_events(); }
+		else
+		{
+			auto deadline = playback_ctrl.next_step_time();
+			if(!file_list_loaded)
+			{
+				auto const next_check = now + std::chrono::milliseconds{100};
+				deadline = std::min(deadline.value_or(next_check), next_check);
+			}
+
+			if(deadline.has_value())
+			{ main_window->wait_events(*deadline - std::chrono::steady_clock::now()); }
+			else
+			{ main_window->wait_events(); }
+		}
 	}
 	pending_tasks.clear();
 
-	set_start_index(statefile, *jobinfo, fullpath, slideshow.get_current_index());
+	auto const pixel_buffer_stats = pixel_buffers.stats();
+	fprintf(
+		stderr,
+		"(i) Pixel buffers: %zu reused, %zu allocated, %zu MiB resident\n",
+		pixel_buffer_stats.hits,
+		pixel_buffer_stats.misses,
+		pixel_buffer_stats.resident_bytes >> 20
+	);
+
+	set_start_index(statefile, jobinfo, fullpath, slideshow.get_current_index());
 	save_statefile(statefile, savestate_dir);
 	return 0;
 }
@@ -475,7 +559,7 @@ int main(int argc, char** argv)
 							"max-pixel-count",
 							slideproj::utils::option_info{
 								.description = "The maximum number of pixels in individual images",
-								.default_value = std::vector{std::string{"33554432"}},
+								.default_value = std::vector{std::string{"268435456"}},
 								.cardinality = 1
 							}
 						},
@@ -488,6 +572,33 @@ int main(int argc, char** argv)
 								.valid_values = slideproj::utils::string_set{"in_group", "timestamp", "caption"}
 							}
 						},
+						std::pair{
+							"scan-threads",
+							slideproj::utils::option_info{
+								.description = "The number of threads used to scan directories and read image metadata",
+								.default_value = std::vector{
+									std::to_string(std::max(std::thread::hardware_concurrency(), 1U))
+								},
+								.cardinality = 1
+							}
+						},
+						std::pair{
+							"scan-index-file",
+							slideproj::utils::option_info{
+								.description = "The file used to remember image metadata between runs. Set to an empty value to disable the index",
+								.default_value = std::vector<std::string>{user_dirs.cache/"slideproj_scan_index.dat"},
+								.cardinality = 1
+							}
+						},
+						std::pair{
+							"output-format",
+							slideproj::utils::option_info{
+								.description = "The format of the list of files. The binary format loads faster in the show action",
+								.default_value = std::vector{std::string{"json"}},
+								.cardinality = 1,
+								.valid_values = slideproj::utils::string_set{"json", "binary"}
+							}
+						},
 						std::pair{
 							"output-file",
 							slideproj::utils::option_info{
@@ -580,6 +691,42 @@ int main(int argc, char** argv)
 								.default_value = std::vector<std::string>{user_dirs.savestates/"slideproj.json"},
 								.cardinality = 1
 							}
+						},
+						std::pair{
+							"loader-threads",
+							slideproj::utils::option_info{
+								.description = "The number of images to load in parallel",
+								.default_value = std::vector{
+									std::to_string(std::clamp(std::thread::hardware_concurrency()/2, 1U, 4U))
+								},
+								.cardinality = 1
+							}
+						},
+						std::pair{
+							"pixel-cache-size",
+							slideproj::utils::option_info{
+								.description = "The number of MiB of released pixel buffers to keep for reuse",
+								.default_value = std::vector<std::string>{"512"},
+								.cardinality = 1
+							}
+						},
+						std::pair{
+							"huge-pages",
+							slideproj::utils::option_info{
+								.description = "Backs large pixel buffers with transparent huge pages",
+								.default_value = std::vector<std::string>{"no"},
+								.cardinality = 1,
+								.valid_values = slideproj::utils::string_set{"no", "yes"}
+							}
+						},
+						std::pair{
+							"log-load-times",
+							slideproj::utils::option_info{
+								.description = "Prints the time spent reading and decoding each image",
+								.default_value = std::vector<std::string>{"no"},
+								.cardinality = 1,
+								.valid_values = slideproj::utils::string_set{"no", "yes"}
+							}
 						}
 					}
 				}
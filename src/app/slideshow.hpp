@@ -71,6 +71,10 @@ namespace slideproj::app
 		void go_to_begin()
 		{ set_current_index(0); }
 
+		// NOTE: Entries are appended at the end, so indices of existing entries do not change
+		void append(file_collector::file_list&& files)
+		{ m_files.append(std::move(files)); }
+
 		ssize_t get_current_index() const
 		{ return m_current_index; }
 
@@ -54,6 +54,14 @@ namespace slideproj::app
 			}
 		}
 
+		// Returns the time of the next automatic step, or nothing if no step is scheduled
+		std::optional<slideshow_clock::time_point> next_step_time() const
+		{
+			if(!m_latest_transtion_end.has_value() || m_params.step_direction == step_direction::none)
+			{ return std::nullopt; }
+			return *m_latest_transtion_end + m_params.step_delay;
+		}
+
 		void toggle_pause()
 		{
 			if(m_params.step_direction == step_direction::none)
@@ -2,12 +2,12 @@
 
 #include "./slideshow_presentation_controller.hpp"
 #include "src/pixel_store/basic_image.hpp"
-#include "src/pixel_store/rgba_image.hpp"
+#include "src/pixel_store/packed_rgba_image.hpp"
 
 
 namespace
 {
-	slideproj::pixel_store::rgba_image display_error()
+	slideproj::pixel_store::packed_rgba_image display_error()
 	{
 		static constexpr const char* message{
 			"                                                                                                             "
@@ -31,19 +31,21 @@ namespace
 		constexpr uint32_t height = 16;
 		constexpr auto width = static_cast<uint32_t>(strlen(message))/height;
 
-		slideproj::pixel_store::rgba_image ret{
+		slideproj::pixel_store::rgba8_srgb_image ret{
 			width,
 			height,
 			slideproj::pixel_store::make_uninitialized_pixel_buffer_tag{}
 		};
 		auto const message_end = message + width*height;
 		std::transform(message, message_end, ret.pixels(), [](auto item){
-			return item == '#'?
-				slideproj::pixel_store::rgba_pixel{1.0f, 1.0f, 1.0f, 1.0f}:
-				slideproj::pixel_store::rgba_pixel{0.0f, 0.0f, 0.0f, 0.0f};
+			return slideproj::pixel_store::make_pixel_from_linear<slideproj::pixel_store::rgba8_srgb_pixel>(
+				item == '#'?
+					slideproj::pixel_store::rgba_pixel{1.0f, 1.0f, 1.0f, 1.0f}:
+					slideproj::pixel_store::rgba_pixel{0.0f, 0.0f, 0.0f, 0.0f}
+			);
 			}
 		);
-		return ret;
+		return slideproj::pixel_store::packed_rgba_image{std::move(ret)};
 	}
 }
 
@@ -65,6 +67,7 @@ void slideproj::app::slideshow_presentation_controller::step_forward()
 	prefetch_image(1);
 	prefetch_image(2);
 	prefetch_image(3);
+	cancel_stale_fetches();
 }
 
 void slideproj::app::slideshow_presentation_controller::step_backward()
@@ -84,6 +87,7 @@ void slideproj::app::slideshow_presentation_controller::step_backward()
 	prefetch_image(-1);
 	prefetch_image(-2);
 	prefetch_image(-3);
+	cancel_stale_fetches();
 }
 
 void slideproj::app::slideshow_presentation_controller::go_to_begin()
@@ -100,6 +104,7 @@ void slideproj::app::slideshow_presentation_controller::go_to_begin()
 	prefetch_image(1);
 	prefetch_image(2);
 	prefetch_image(3);
+	cancel_stale_fetches();
 }
 
 void slideproj::app::slideshow_presentation_controller::go_to_end()
@@ -116,6 +121,7 @@ void slideproj::app::slideshow_presentation_controller::go_to_end()
 	prefetch_image(-1);
 	prefetch_image(-2);
 	prefetch_image(-3);
+	cancel_stale_fetches();
 }
 
 void slideproj::app::slideshow_presentation_controller::start_slideshow(std::reference_wrapper<slideshow> slideshow)
@@ -123,7 +129,10 @@ void slideproj::app::slideshow_presentation_controller::start_slideshow(std::ref
 	utils::unwrap(m_task_queue).clear();
 	m_loaded_images.clear();
 	m_current_slideshow = &slideshow.get();
-	m_present_immediately.clear();
+	m_fetch_pending.clear();
+	m_present_when_fetched.clear();
+	m_fetch_tasks.clear();
+	m_pending_fetches.clear();
 	m_transition_start.reset();
 	m_image_display.set_transition_param(m_image_display.object, 1.0f);
 
@@ -140,6 +149,16 @@ void slideproj::app::slideshow_presentation_controller::start_slideshow(std::ref
 	prefetch_image(-3);
 }
 
+void slideproj::app::slideshow_presentation_controller::handle_appended_entries()
+{
+	if(m_current_slideshow == nullptr)
+	{ return; }
+
+	prefetch_image(1);
+	prefetch_image(2);
+	prefetch_image(3);
+}
+
 void slideproj::app::slideshow_presentation_controller::present_image(slideshow_entry const& entry)
 {
 	if(!entry.is_valid())
@@ -154,11 +173,13 @@ void slideproj::app::slideshow_presentation_controller::present_image(slideshow_
 	{ present_image(*cached_entry); }
 	else
 	{
-		auto ip = m_present_immediately.insert(std::pair{entry.source_file.id(), true});
-		if(ip.second)
-		{ fetch_image(entry); }
+		auto const id = entry.source_file.id();
+		auto const was_pending = is_fetch_pending(id);
+		set_fetch_pending(id, true);
+		if(!was_pending)
+		{ fetch_image(entry, utils::task_priority::high); }
 		else
-		{ ip.first->second = true; }
+		{ unwrap(m_task_queue).raise_priority(m_fetch_tasks[id.value()], utils::task_priority::high); }
 	}
 }
 
@@ -172,21 +193,52 @@ void slideproj::app::slideshow_presentation_controller::prefetch_image(ssize_t o
 	if(cached_entry.has_value() && cached_entry->source_file.id() == entry.source_file.id())
 	{ return; }
 
-	if(m_present_immediately.insert(std::pair{entry.source_file.id(), false}).second)
-	{ fetch_image(entry); }
+	auto const id = entry.source_file.id();
+	auto const priority = offset == 1 || offset == -1? utils::task_priority::medium : utils::task_priority::low;
+	if(!is_fetch_pending(id))
+	{
+		set_fetch_pending(id, false);
+		fetch_image(entry, priority);
+	}
+	else
+	{ unwrap(m_task_queue).raise_priority(m_fetch_tasks[id.value()], priority); }
 }
 
-void slideproj::app::slideshow_presentation_controller::fetch_image(slideshow_entry const& entry)
+void slideproj::app::slideshow_presentation_controller::fetch_image(
+	slideshow_entry const& entry,
+	utils::task_priority priority
+)
 {
-	unwrap(m_task_queue).submit(
+	auto const task_id = unwrap(m_task_queue).submit(
 		utils::task{
+			// NOTE: source_file refers to paths owned by the slideshow, which outlives the task queue
 			.function = [
-				path_to_load = entry.source_file.path(),
-				rect = m_target_rectangle
-			](){
+				source_file = entry.source_file,
+				rect = m_target_rectangle,
+				&pixel_workers = unwrap(m_pixel_workers),
+				log_load_times = m_params.log_load_times
+			](std::stop_token const& stop_token, std::atomic<utils::task_priority> const& priority){
+				auto const path_to_load = source_file.path();
 				try
 				{
-					auto ret = image_file_loader::load_rgba_image(path_to_load, rect);
+					// NOTE: The image the user is waiting for gets the whole machine. Prefetches only use
+					//       workers that would otherwise be idle. If the user steps onto an image that is
+					//       being prefetched, present_image raises the priority, and the remaining rows
+					//       are processed in the foreground.
+					auto const get_work_priority = [&priority](){
+						return priority.load(std::memory_order_relaxed) == utils::task_priority::high?
+							utils::work_priority::foreground:
+							utils::work_priority::background;
+					};
+					image_file_loader::image_load_timings timings;
+					auto ret = image_file_loader::load_packed_rgba_image(
+						path_to_load,
+						rect,
+						pixel_workers,
+						utils::work_priority_source{get_work_priority},
+						timings,
+						stop_token
+					);
 					if(ret.is_empty())
 					{
 						fprintf(stderr, "(!) Failed to load image %s", path_to_load.c_str());
@@ -194,8 +246,22 @@ void slideproj::app::slideshow_presentation_controller::fetch_image(slideshow_en
 						return display_error();
 
 					}
+
+					if(log_load_times)
+					{
+						using milliseconds = std::chrono::duration<double, std::milli>;
+						fprintf(
+							stderr,
+							"(i) Loaded %s (read: %.1f ms, decode: %.1f ms)\n",
+							path_to_load.c_str(),
+							milliseconds{timings.read_time}.count(),
+							milliseconds{timings.decode_time}.count()
+						);
+					}
 					return ret;
 				}
+				catch(utils::operation_cancelled const&)
+				{ throw; }
 				catch(...)
 				{
 					fprintf(stderr, "(!) Failed to load image %s", path_to_load.c_str());
@@ -211,7 +277,13 @@ void slideproj::app::slideshow_presentation_controller::fetch_image(slideshow_en
 			](auto&& result) mutable {
 				if(saved_rect != m_target_rectangle)
 				{
-					fetch_image(entry);
+					auto const id = entry.source_file.id();
+					fetch_image(
+						entry,
+						is_fetch_pending(id) && m_present_when_fetched[id.value()]?
+							utils::task_priority::high:
+							utils::task_priority::low
+					);
 					return;
 				}
 
@@ -222,16 +294,22 @@ void slideproj::app::slideshow_presentation_controller::fetch_image(slideshow_en
 					.target_rectangle = saved_rect
 				};
 
-				auto i = m_present_immediately.find(cached_entry->source_file.id());
-				if(i != std::end(m_present_immediately))
+				auto const id = cached_entry->source_file.id();
+				if(is_fetch_pending(id))
 				{
-					if(i->second)
+					m_fetch_pending[id.value()] = false;
+					if(m_present_when_fetched[id.value()])
 					{ present_image(*cached_entry); }
-					m_present_immediately.erase(i);
 				}
 			}
-		}
+		},
+		priority
 	);
+
+	// NOTE: A task that completes after the slideshow has been restarted may refetch an entry that
+	//       is no longer tracked
+	if(auto const index = entry.source_file.id().value(); index < std::size(m_fetch_tasks))
+	{ m_fetch_tasks[index] = task_id; }
 }
 
 void slideproj::app::slideshow_presentation_controller::present_image(loaded_image const& img)
@@ -239,13 +317,58 @@ void slideproj::app::slideshow_presentation_controller::present_image(loaded_ima
 	m_image_display.set_transition_param(m_image_display.object, 0.0f);
 	m_image_display.show_image(m_image_display.object, img.image_data);
 	m_transition_start = clock::now();
-	auto const& caption = m_file_metadata_provider.get_metadata(
-		m_file_metadata_provider.object, img.source_file
-	).caption;
+	std::string const caption{
+		m_file_metadata_provider.get_metadata(m_file_metadata_provider.object, img.source_file).caption
+	};
 
 	m_title_display.set_title(m_title_display.object, caption.c_str());
 }
 
+void slideproj::app::slideshow_presentation_controller::set_fetch_pending(
+	file_collector::file_id id,
+	bool present_when_fetched
+)
+{
+	auto const index = id.value();
+	if(index >= std::size(m_fetch_pending))
+	{
+		m_fetch_pending.resize(index + 1);
+		m_present_when_fetched.resize(index + 1);
+		m_fetch_tasks.resize(index + 1);
+	}
+	if(!m_fetch_pending[index])
+	{ m_pending_fetches.push_back(id); }
+	m_fetch_pending[index] = true;
+	m_present_when_fetched[index] = present_when_fetched;
+}
+
+void slideproj::app::slideshow_presentation_controller::cancel_stale_fetches()
+{
+	// NOTE: Entries that the user has moved away from may take long to load, and would only be
+	//       thrown out of m_loaded_images soon anyway
+	auto const is_within_reach = [this](file_collector::file_id id) {
+		for(ssize_t offset = -3; offset <= 3; ++offset)
+		{
+			auto const entry = m_current_slideshow->get_entry(offset);
+			if(entry.is_valid() && entry.source_file.id() == id)
+			{ return true; }
+		}
+		return false;
+	};
+
+	std::erase_if(m_pending_fetches, [this, &is_within_reach](file_collector::file_id id) {
+		if(!is_fetch_pending(id))
+		{ return true; }
+
+		if(is_within_reach(id))
+		{ return false; }
+
+		unwrap(m_task_queue).cancel(m_fetch_tasks[id.value()]);
+		m_fetch_pending[id.value()] = false;
+		return true;
+	});
+}
+
 void slideproj::app::slideshow_presentation_controller::update_clock(clock::time_point now)
 {
 	if(m_transition_start.has_value())
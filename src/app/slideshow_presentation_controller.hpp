@@ -9,9 +9,12 @@
 #include "src/pixel_store/basic_image.hpp"
 #include "src/utils/rotating_cache.hpp"
 #include "src/image_file_loader/image_file_loader.hpp"
-#include "src/pixel_store/rgba_image.hpp"
+#include "src/pixel_store/packed_rgba_image.hpp"
 #include "src/utils/unwrap.hpp"
 #include "src/utils/task_queue.hpp"
+#include "src/utils/thread_pool.hpp"
+
+#include <vector>
 
 namespace slideproj::app
 {
@@ -19,12 +22,12 @@ namespace slideproj::app
 	{
 		ssize_t index;
 		file_collector::file_list_entry source_file;
-		pixel_store::rgba_image image_data;
+		pixel_store::packed_rgba_image image_data;
 		pixel_store::image_rectangle target_rectangle;
 	};
 
 	template<class T>
-	concept image_display = requires(T& x, pixel_store::rgba_image const& img, float t)
+	concept image_display = requires(T& x, pixel_store::packed_rgba_image const& img, float t)
 	{
 		{x.show_image(img)}->std::same_as<void>;
 		{x.set_transition_param(t)}->std::same_as<void>;
@@ -33,7 +36,7 @@ namespace slideproj::app
 	struct type_erased_image_display
 	{
 		void* object;
-		void (*show_image)(void*, pixel_store::rgba_image const&);
+		void (*show_image)(void*, pixel_store::packed_rgba_image const&);
 		void (*set_transition_param)(void*, float);
 	};
 
@@ -72,6 +75,7 @@ namespace slideproj::app
 	{
 		slideshow_clock::duration transition_duration = std::chrono::seconds{2};
 		bool loop = true;
+		bool log_load_times = false;
 	};
 
 	class slideshow_presentation_controller : public slideshow_navigator
@@ -87,6 +91,7 @@ namespace slideproj::app
 		>
 		explicit slideshow_presentation_controller(
 			utils::task_queue& task_queue,
+			utils::thread_pool& pixel_workers,
 			ImageDisplay& img_display,
 			TitleDisplay& title_display,
 			std::reference_wrapper<FileMetadataProvider const> file_metadata_provider,
@@ -94,9 +99,10 @@ namespace slideproj::app
 			slideshow_presentation_descriptor const& params
 		):
 			m_task_queue{task_queue},
+			m_pixel_workers{pixel_workers},
 			m_image_display{
 				.object = &img_display,
-				.show_image = [](void* object, pixel_store::rgba_image const& img) {
+				.show_image = [](void* object, pixel_store::packed_rgba_image const& img) {
 					static_cast<ImageDisplay*>(object)->show_image(img);
 				},
 				.set_transition_param = [](void* object, float t) {
@@ -112,7 +118,7 @@ namespace slideproj::app
 			m_file_metadata_provider{
 				.object = &file_metadata_provider.get(),
 				.get_metadata = [](void const* object, file_collector::file_list_entry const& item)
-					->file_collector::file_metadata const& {
+					->file_collector::file_metadata {
 					return static_cast<FileMetadataProvider const*>(object)->get_metadata(item);
 				}
 			},
@@ -148,18 +154,33 @@ namespace slideproj::app
 
 		void start_slideshow(std::reference_wrapper<slideshow> slideshow);
 
+		// Should be called after entries have been appended to the current slideshow
+		void handle_appended_entries();
+
 		void present_image(slideshow_entry const& entry);
 
 		void prefetch_image(ssize_t offset);
 
-		void fetch_image(slideshow_entry const& entry);
+		void fetch_image(slideshow_entry const& entry, utils::task_priority priority);
 
 		void present_image(loaded_image const& img);
 
 		void update_clock(clock::time_point now);
 
+		bool transition_is_running() const
+		{ return m_transition_start.has_value(); }
+
 	private:
+		bool is_fetch_pending(file_collector::file_id id) const
+		{ return id.value() < std::size(m_fetch_pending) && m_fetch_pending[id.value()]; }
+
+		void set_fetch_pending(file_collector::file_id id, bool present_when_fetched);
+
+		void cancel_stale_fetches();
+
 		std::reference_wrapper<utils::task_queue> m_task_queue;
+		// NOTE: Used to process the rows of an image in parallel, while it is being loaded
+		std::reference_wrapper<utils::thread_pool> m_pixel_workers;
 		slideshow* m_current_slideshow{nullptr};
 		pixel_store::image_rectangle m_target_rectangle{};
 		utils::rotating_cache<loaded_image, utils::power_of_two{3}> m_loaded_images;
@@ -167,7 +188,14 @@ namespace slideproj::app
 		type_erased_title_display m_title_display;
 		file_collector::type_erased_file_metadata_provider m_file_metadata_provider;
 		type_erased_slideshow_event_handler m_event_handler;
-		std::unordered_map<file_collector::file_id, bool> m_present_immediately;
+		// NOTE: Indexed by file id. A file is in m_fetch_pending while it is being loaded, and
+		//       m_present_when_fetched tells whether it should be presented when it arrives.
+		//       m_fetch_tasks holds the task that loads the file. m_pending_fetches lists the files
+		//       that have been pending since the last call to cancel_stale_fetches.
+		std::vector<bool> m_fetch_pending;
+		std::vector<bool> m_present_when_fetched;
+		std::vector<utils::task_id> m_fetch_tasks;
+		std::vector<file_collector::file_id> m_pending_fetches;
 		std::optional<clock::time_point> m_transition_start;
 
 		slideshow_presentation_descriptor m_params;
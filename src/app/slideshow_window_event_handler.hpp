@@ -85,8 +85,15 @@ namespace slideproj::app
 				item.set_window_size(item.object, rect);
 			}
 			glViewport(0, 0, w, h);
+			m_window_is_damaged = true;
 		}
 
+		void handle_event(
+			windowing_api::application_window&,
+			windowing_api::window_damaged_event
+		)
+		{ m_window_is_damaged = true; }
+
 		void handle_event(
 			windowing_api::application_window&,
 			slideproj::windowing_api::window_is_closing_event
@@ -156,10 +163,15 @@ namespace slideproj::app
 		bool application_should_exit() const
 		{ return m_application_should_exit; }
 
+		// Returns true if the window has been damaged since the previous call
+		bool take_window_damage()
+		{ return std::exchange(m_window_is_damaged, false); }
+
 	private:
 		std::reference_wrapper<slideshow_navigator> m_navigator;
 		std::vector<image_rect_sink_ref> m_rect_sinks;
 		bool m_application_should_exit{false};
+		bool m_window_is_damaged{true};
 		type_erased_playback_controller m_playback_controller;
 	};
 }
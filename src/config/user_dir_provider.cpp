@@ -29,18 +29,29 @@ std::filesystem::path slideproj::config::get_state_dir()
 	return state_dir_env;
 }
 
+std::filesystem::path slideproj::config::get_cache_dir()
+{
+	auto const cache_dir_env = getenv("XDG_CACHE_HOME");
+	if(cache_dir_env == nullptr)
+	{ return ".cache"; }
+	return cache_dir_env;
+}
+
 slideproj::config::user_dirs
 slideproj::config::get_user_dirs()
 {
 	auto const home = get_home_dir();
 	auto const pictures = home/dgettext("xdg-user-dirs", "Pictures");
 	auto const state = home/get_state_dir();
+	auto const cache = home/get_cache_dir();
 
 	std::filesystem::create_directories(pictures);
 	std::filesystem::create_directories(state);
+	std::filesystem::create_directories(cache);
 
 	return user_dirs{
 		.pictures = std::move(pictures),
-		.savestates = std::move(state)
+		.savestates = std::move(state),
+		.cache = std::move(cache)
 	};
 }
\ No newline at end of file
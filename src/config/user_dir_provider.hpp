@@ -11,12 +11,15 @@ namespace slideproj::config
 	{
 		std::filesystem::path pictures;
 		std::filesystem::path savestates;
+		std::filesystem::path cache;
 	};
 
 	std::filesystem::path get_home_dir();
 
 	std::filesystem::path get_state_dir();
 
+	std::filesystem::path get_cache_dir();
+
 	user_dirs get_user_dirs();
 }
 
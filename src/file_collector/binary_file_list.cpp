@@ -0,0 +1,168 @@
+//@	{"target": {"name":"binary_file_list.o"}}
+
+#include "./binary_file_list.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	static_assert(std::endian::native == std::endian::little);
+
+	constexpr std::array<char, 8> file_list_magic{'S', 'P', 'F', 'L', 'I', 'S', 'T', '\0'};
+	constexpr uint32_t file_list_version = 1;
+	constexpr size_t header_size = std::size(file_list_magic) + 2*sizeof(uint32_t) + 3*sizeof(uint64_t);
+
+	constexpr size_t padded_size(size_t size)
+	{ return (size + 7) & ~static_cast<size_t>(7); }
+
+	template<class T>
+	requires(std::is_trivially_copyable_v<T>)
+	void write_value(std::ostream& output, T const& value)
+	{ output.write(reinterpret_cast<char const*>(&value), sizeof(value)); }
+
+	template<class T>
+	requires(std::is_trivially_copyable_v<T>)
+	T read_value(std::span<char const> data, size_t offset)
+	{
+		T ret;
+		memcpy(&ret, std::data(data) + offset, sizeof(T));
+		return ret;
+	}
+}
+
+bool slideproj::file_collector::is_binary_file_list(std::span<char const> data)
+{
+	return std::size(data) >= std::size(file_list_magic)
+		&& std::ranges::equal(data.first(std::size(file_list_magic)), file_list_magic);
+}
+
+void slideproj::file_collector::write_binary_file_list(
+	std::ostream& output,
+	std::string_view jobinfo,
+	file_list const& files,
+	std::filesystem::path const& working_directory
+)
+{
+	std::vector<std::string> paths;
+	paths.reserve(std::size(files));
+	for(auto const& item : files)
+	{
+		// NOTE: Use the same normalization as when a JSON file list is loaded
+		std::error_code ec;
+		auto resolved_path = canonical(working_directory/item.path(), ec);
+		if(ec)
+		{
+			fprintf(stderr, "(!) Skipping %s: %s\n", item.path().c_str(), ec.message().c_str());
+			continue;
+		}
+		paths.push_back(std::move(resolved_path).native());
+	}
+
+	std::vector<uint64_t> offsets;
+	offsets.reserve(std::size(paths));
+	uint64_t blob_size = 0;
+	for(auto const& item : paths)
+	{
+		offsets.push_back(blob_size);
+		blob_size += std::size(item) + 1;
+	}
+
+	output.write(std::data(file_list_magic), std::size(file_list_magic));
+	write_value(output, file_list_version);
+	write_value(output, static_cast<uint32_t>(0));
+	write_value(output, static_cast<uint64_t>(std::size(jobinfo)));
+	write_value(output, static_cast<uint64_t>(std::size(paths)));
+	write_value(output, blob_size);
+	output.write(std::data(jobinfo), std::ssize(jobinfo));
+	std::array<char, 8> const padding{};
+	output.write(
+		std::data(padding),
+		static_cast<std::streamsize>(padded_size(std::size(jobinfo)) - std::size(jobinfo))
+	);
+	output.write(
+		reinterpret_cast<char const*>(std::data(offsets)),
+		static_cast<std::streamsize>(std::size(offsets)*sizeof(uint64_t))
+	);
+	for(auto const& item : paths)
+	{ output.write(item.c_str(), std::ssize(item) + 1); }
+
+	if(!output.flush())
+	{ throw std::runtime_error{"Failed to write file list"}; }
+}
+
+slideproj::file_collector::binary_file_list_view::binary_file_list_view(std::span<char const> data)
+{
+	if(!is_binary_file_list(data) || std::size(data) < header_size)
+	{ throw std::runtime_error{"Not a binary file list"}; }
+
+	if(read_value<uint32_t>(data, 8) != file_list_version)
+	{ throw std::runtime_error{"Unsupported binary file list version"}; }
+
+	auto const jobinfo_size = read_value<uint64_t>(data, 16);
+	auto const entry_count = read_value<uint64_t>(data, 24);
+	auto const blob_size = read_value<uint64_t>(data, 32);
+
+	// Checks are written so that they cannot overflow
+	auto remaining = std::size(data) - header_size;
+	if(jobinfo_size > remaining || padded_size(jobinfo_size) > remaining)
+	{ throw std::runtime_error{"Truncated binary file list"}; }
+	remaining -= padded_size(jobinfo_size);
+
+	if(entry_count > remaining/sizeof(uint64_t))
+	{ throw std::runtime_error{"Truncated binary file list"}; }
+	remaining -= entry_count*sizeof(uint64_t);
+
+	if(blob_size != remaining)
+	{ throw std::runtime_error{"Invalid size of path blob in binary file list"}; }
+
+	auto const offsets_begin = header_size + padded_size(jobinfo_size);
+	m_jobinfo = std::string_view{std::data(data) + header_size, jobinfo_size};
+	m_entry_count = entry_count;
+	m_offsets = data.subspan(offsets_begin, entry_count*sizeof(uint64_t));
+	m_blob = data.subspan(offsets_begin + entry_count*sizeof(uint64_t));
+	if(entry_count != 0 && (blob_size == 0 || m_blob.back() != '\0'))
+	{ throw std::runtime_error{"Invalid path blob in binary file list"}; }
+}
+
+std::string_view slideproj::file_collector::binary_file_list_view::path(size_t index) const
+{
+	auto const begin = read_value<uint64_t>(m_offsets, index*sizeof(uint64_t));
+	auto const end = index + 1 != m_entry_count?
+		read_value<uint64_t>(m_offsets, (index + 1)*sizeof(uint64_t)) :
+		std::size(m_blob);
+	if(begin >= end || end > std::size(m_blob) || m_blob[end - 1] != '\0')
+	{ throw std::runtime_error{"Invalid path offset in binary file list"}; }
+
+	return std::string_view{std::data(m_blob) + begin, end - begin - 1};
+}
+
+void slideproj::file_collector::binary_file_list_view::append_entries(
+	file_list& output,
+	size_t begin,
+	size_t end
+) const
+{
+	end = std::min(end, m_entry_count);
+	for(auto k = begin; k < end; ++k)
+	{ output.append_unowned(path(k)); }
+}
+
+slideproj::file_collector::binary_file_list
+slideproj::file_collector::load_binary_file_list(std::span<char const> data)
+{
+	binary_file_list_view const view{data};
+	binary_file_list ret{
+		.jobinfo = view.jobinfo(),
+		.files = file_list{}
+	};
+	ret.files.reserve(std::size(view));
+	view.append_entries(ret.files, 0, std::size(view));
+	return ret;
+}
@@ -0,0 +1,75 @@
+//@	{"dependencies_extra":[{"ref":"./binary_file_list.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_FILE_COLLECTOR_BINARY_FILE_LIST_HPP
+#define SLIDEPROJ_FILE_COLLECTOR_BINARY_FILE_LIST_HPP
+
+#include "./file_collector.hpp"
+
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string_view>
+
+namespace slideproj::file_collector
+{
+	// File layout, using native byte order:
+	//
+	//   magic "SPFLIST\0"
+	//   u32 version, u32 reserved
+	//   u64 jobinfo size, u64 entry count, u64 path blob size
+	//   jobinfo, padded to a multiple of 8 bytes
+	//   u64 offsets[entry count], relative to the start of the path blob
+	//   path blob, with null-terminated absolute paths
+	//
+	// Paths are canonical, like those loaded from a JSON file list, so a reader does not need to
+	// resolve them against a working directory.
+	bool is_binary_file_list(std::span<char const> data);
+
+	// NOTE: Files that cannot be resolved, because they have been removed since they were collected,
+	//       are left out
+	void write_binary_file_list(
+		std::ostream& output,
+		std::string_view jobinfo,
+		file_list const& files,
+		std::filesystem::path const& working_directory
+	);
+
+	// Gives access to the entries of a binary file list. Only the header is validated up front, and
+	// entries are located through the offset table when they are requested. Thus, opening a list
+	// takes the same time regardless of its length.
+	//
+	// NOTE: The object refers to data, which must outlive it
+	class binary_file_list_view
+	{
+	public:
+		explicit binary_file_list_view(std::span<char const> data);
+
+		std::string_view jobinfo() const
+		{ return m_jobinfo; }
+
+		size_t size() const
+		{ return m_entry_count; }
+
+		std::string_view path(size_t index) const;
+
+		// Appends the entries within [begin, end) to output. No paths are copied.
+		void append_entries(file_list& output, size_t begin, size_t end) const;
+
+	private:
+		std::string_view m_jobinfo;
+		size_t m_entry_count;
+		std::span<char const> m_offsets;
+		std::span<char const> m_blob;
+	};
+
+	struct binary_file_list
+	{
+		std::string_view jobinfo;
+		file_list files;
+	};
+
+	// NOTE: The returned object refers to data, which must outlive it. No paths are copied.
+	binary_file_list load_binary_file_list(std::span<char const> data);
+}
+
+#endif
@@ -0,0 +1,105 @@
+//@	{"target":{"name":"binary_file_list.test"}}
+
+#include "./binary_file_list.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+	std::filesystem::path make_test_directory()
+	{
+		auto const ret = std::filesystem::temp_directory_path()/"slideproj_binary_file_list_test";
+		std::filesystem::remove_all(ret);
+		std::filesystem::create_directories(ret/"foo");
+		std::ofstream{ret/"foo/lenna.jpg"};
+		std::ofstream{ret/"kaka.jpg"};
+		std::filesystem::create_symlink("kaka.jpg", ret/"link.jpg");
+		return canonical(ret);
+	}
+}
+
+TESTCASE(slideproj_file_collector_binary_file_list_write_and_load)
+{
+	auto const wd = make_test_directory();
+	slideproj::file_collector::file_list files;
+	files.append("foo/lenna.jpg")
+		.append("foo/does_not_exist.jpg")
+		.append((wd/"foo/../kaka.jpg").native())
+		.append("link.jpg");
+
+	std::ostringstream output;
+	write_binary_file_list(output, R"({"working_directory":"/tmp"})", files, wd);
+	auto const data = output.str();
+
+	// NOTE: Paths are canonical, as they are when a JSON file list is loaded
+	REQUIRE_EQ(slideproj::file_collector::is_binary_file_list(data), true);
+	auto const res = slideproj::file_collector::load_binary_file_list(data);
+	EXPECT_EQ(res.jobinfo, R"({"working_directory":"/tmp"})");
+	REQUIRE_EQ(std::size(res.files), 3);
+	EXPECT_EQ(res.files[0].path(), wd/"foo/lenna.jpg");
+	EXPECT_EQ(res.files[1].path(), wd/"kaka.jpg");
+	EXPECT_EQ(res.files[2].path(), wd/"kaka.jpg");
+	EXPECT_EQ(res.files[2].id(), slideproj::file_collector::file_id{2});
+}
+
+TESTCASE(slideproj_file_collector_binary_file_list_view)
+{
+	auto const wd = make_test_directory();
+	slideproj::file_collector::file_list files;
+	files.append("foo/lenna.jpg")
+		.append("kaka.jpg");
+
+	std::ostringstream output;
+	write_binary_file_list(output, "{}", files, wd);
+	auto const data = output.str();
+
+	slideproj::file_collector::binary_file_list_view const view{data};
+	EXPECT_EQ(view.jobinfo(), "{}");
+	REQUIRE_EQ(std::size(view), 2);
+	EXPECT_EQ(std::filesystem::path{view.path(1)}, wd/"kaka.jpg");
+
+	slideproj::file_collector::file_list loaded;
+	view.append_entries(loaded, 1, 16);
+	view.append_entries(loaded, 0, 1);
+	REQUIRE_EQ(std::size(loaded), 2);
+	EXPECT_EQ(loaded[0].path(), wd/"kaka.jpg");
+	EXPECT_EQ(loaded[1].path(), wd/"foo/lenna.jpg");
+}
+
+TESTCASE(slideproj_file_collector_binary_file_list_empty)
+{
+	std::ostringstream output;
+	write_binary_file_list(output, "{}", slideproj::file_collector::file_list{}, "/tmp");
+	auto const data = output.str();
+
+	auto const res = slideproj::file_collector::load_binary_file_list(data);
+	EXPECT_EQ(res.jobinfo, "{}");
+	EXPECT_EQ(std::size(res.files), 0);
+}
+
+TESTCASE(slideproj_file_collector_binary_file_list_invalid_data)
+{
+	EXPECT_EQ(slideproj::file_collector::is_binary_file_list(std::string_view{R"({"files":[]})"}), false);
+
+	slideproj::file_collector::file_list files;
+	files.append("foo/lenna.jpg");
+	std::ostringstream output;
+	write_binary_file_list(output, "{}", files, make_test_directory());
+	auto const data = output.str();
+
+	for(size_t k = 0; k != std::size(data); ++k)
+	{
+		auto const truncated = std::string_view{data}.substr(0, k);
+		auto failed = false;
+		try
+		{ (void)slideproj::file_collector::load_binary_file_list(truncated); }
+		catch(std::runtime_error const&)
+		{ failed = true; }
+		EXPECT_EQ(failed, true);
+	}
+}
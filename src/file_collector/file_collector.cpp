@@ -1,10 +1,25 @@
 //@	{"target": {"name":"file_collector.o"}}
 
 #include "./file_collector.hpp"
+
+#include "src/utils/parallel_for.hpp"
+
 #include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
 #include <numeric>
+#include <cstdio>
+#include <cstring>
 #include <sys/stat.h>
 #include <filesystem>
+#include <system_error>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <exception>
 
 std::vector<slideproj::file_collector::file_metadata_field>
 slideproj::file_collector::make_metadata_field_array(std::vector<std::string> const& strings)
@@ -24,59 +39,505 @@ slideproj::file_collector::make_metadata_field_array(std::vector<std::string> co
 	return ret;
 }
 
+namespace
+{
+	class directory_handle
+	{
+	public:
+		explicit directory_handle(int fd):m_fd{fd}
+		{}
+
+		directory_handle(directory_handle const&) = delete;
+		directory_handle& operator=(directory_handle const&) = delete;
+
+		~directory_handle()
+		{ close(m_fd); }
+
+		int get() const
+		{ return m_fd; }
+
+	private:
+		int m_fd;
+	};
+
+	struct directory_node;
+
+	struct directory_item
+	{
+		std::string file;
+		std::unique_ptr<directory_node> subdirectory;
+	};
+
+	struct directory_node
+	{
+		// NOTE: For subdirectories, the directory is opened relative to parent, using the last
+		//       component of path.
+		std::string path;
+		std::shared_ptr<directory_handle const> parent;
+		std::vector<directory_item> items;
+	};
+
+	std::shared_ptr<directory_handle const> open_directory(directory_node const& node)
+	{
+		auto const fd = [](directory_node const& node){
+			if(node.parent == nullptr)
+			{ return open(node.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); }
+
+			auto const name_begin = node.path.find_last_of('/') + 1;
+			return openat(
+				node.parent->get(),
+				node.path.c_str() + name_begin,
+				O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW
+			);
+		}(node);
+
+		// NOTE: Subdirectories may be unreadable, or removed while the scan is running. Skip them, so
+		//       the rest of the scan can complete. An input directory that cannot be opened is an
+		//       error.
+		if(fd == -1)
+		{
+			if(node.parent == nullptr)
+			{
+				throw std::filesystem::filesystem_error{
+					"Failed to open directory",
+					node.path,
+					std::error_code{errno, std::system_category()}
+				};
+			}
+
+			fprintf(stderr, "(!) Skipping directory %s: %s\n", node.path.c_str(), strerror(errno));
+			return nullptr;
+		}
+
+		return std::make_shared<directory_handle const>(fd);
+	}
+
+	enum class directory_entry_type{directory, file, symlink_to_file, other};
+
+	directory_entry_type get_directory_entry_type(int dir_fd, dirent64 const& entry)
+	{
+		switch(entry.d_type)
+		{
+			case DT_DIR:
+				return directory_entry_type::directory;
+			case DT_REG:
+				return directory_entry_type::file;
+			case DT_LNK:
+			{
+				// Symlinks to regular files are accepted, but symlinks to directories are not
+				// followed, as that could lead to cycles
+				struct stat statbuf{};
+				if(fstatat(dir_fd, entry.d_name, &statbuf, 0) == -1)
+				{ return directory_entry_type::other; }
+				return S_ISREG(statbuf.st_mode)? directory_entry_type::symlink_to_file : directory_entry_type::other;
+			}
+			case DT_UNKNOWN:
+			{
+				// Not all file systems report the file type. Fall back to stat in that case.
+				struct stat statbuf{};
+				if(fstatat(dir_fd, entry.d_name, &statbuf, AT_SYMLINK_NOFOLLOW) == -1)
+				{ return directory_entry_type::other; }
+
+				if(S_ISDIR(statbuf.st_mode))
+				{ return directory_entry_type::directory; }
+
+				if(S_ISLNK(statbuf.st_mode))
+				{
+					if(fstatat(dir_fd, entry.d_name, &statbuf, 0) == -1)
+					{ return directory_entry_type::other; }
+					return S_ISREG(statbuf.st_mode)? directory_entry_type::symlink_to_file : directory_entry_type::other;
+				}
+
+				return S_ISREG(statbuf.st_mode)? directory_entry_type::file : directory_entry_type::other;
+			}
+			default:
+				return directory_entry_type::other;
+		}
+	}
+
+	bool is_dot_or_dotdot(char const* name)
+	{ return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')); }
+
+	class directory_scanner
+	{
+	public:
+		explicit directory_scanner(
+			slideproj::file_collector::type_erased_input_filter input_filter,
+			size_t worker_count
+		):
+			m_input_filter{input_filter},
+			m_queues(std::max(worker_count, static_cast<size_t>(1)))
+		{}
+
+		void scan(std::span<directory_node> roots)
+		{
+			for(size_t k = 0; k != std::size(roots); ++k)
+			{ push(k%std::size(m_queues), roots[k]); }
+
+			{
+				std::vector<std::jthread> workers;
+				for(size_t k = 1; k < std::size(m_queues); ++k)
+				{ workers.emplace_back([this, k](){ run_worker(k); }); }
+				run_worker(0);
+			}
+
+			if(m_error)
+			{ std::rethrow_exception(m_error); }
+		}
+
+	private:
+		struct worker_queue
+		{
+			std::mutex mutex;
+			std::deque<directory_node*> tasks;
+		};
+
+		// NOTE: Large buffers means fewer getdents64 calls for directories with a huge fan-out. The
+		//       size passed to getdents64 must not exceed the allocation, so it is computed from the
+		//       number of elements.
+		static constexpr size_t dirent_buffer_count = 256*1024/sizeof(dirent64);
+		static constexpr size_t dirent_buffer_size = dirent_buffer_count*sizeof(dirent64);
+
+		struct worker_state
+		{
+			std::unique_ptr<dirent64[]> dirent_buffer{
+				std::make_unique_for_overwrite<dirent64[]>(dirent_buffer_count)
+			};
+			std::string path_buffer;
+		};
+
+		void run_worker(size_t index)
+		{
+			worker_state state;
+			while(auto const node = next_task(index))
+			{
+				try
+				{ scan_directory(index, state, *node); }
+				catch(...)
+				{ set_error(std::current_exception()); }
+				task_done();
+			}
+		}
+
+		void scan_directory(size_t worker_index, worker_state& state, directory_node& node)
+		{
+			auto const dir = open_directory(node);
+			node.parent.reset();
+			if(dir == nullptr)
+			{ return; }
+
+			auto& path_buffer = state.path_buffer;
+			path_buffer = node.path;
+			if(!path_buffer.empty() && path_buffer.back() != '/')
+			{ path_buffer += '/'; }
+			auto const prefix_length = std::size(path_buffer);
+
+			auto const buffer = reinterpret_cast<char*>(state.dirent_buffer.get());
+			while(true)
+			{
+				auto const bytes_read = getdents64(dir->get(), buffer, dirent_buffer_size);
+				if(bytes_read == -1)
+				{
+					// NOTE: Keep the entries that have been read so far
+					fprintf(stderr, "(!) Failed to read directory %s: %s\n", node.path.c_str(), strerror(errno));
+					return;
+				}
+
+				if(bytes_read == 0)
+				{ return; }
+
+				auto const buffer_end = buffer + bytes_read;
+				auto ptr = buffer;
+				while(ptr != buffer_end)
+				{
+					auto const& entry = *reinterpret_cast<dirent64 const*>(ptr);
+					ptr += entry.d_reclen;
+
+					if(is_dot_or_dotdot(entry.d_name))
+					{ continue; }
+
+					// For now, only store regular files. Directories could be useful to generate
+					// automatic title screens
+					switch(get_directory_entry_type(dir->get(), entry))
+					{
+						case directory_entry_type::directory:
+						{
+							path_buffer.resize(prefix_length);
+							path_buffer += entry.d_name;
+							auto subdirectory = std::make_unique<directory_node>(directory_node{
+								.path = path_buffer,
+								.parent = dir,
+								.items = {}
+							});
+							push(worker_index, *subdirectory);
+							node.items.push_back(directory_item{
+								.file = {},
+								.subdirectory = std::move(subdirectory)
+							});
+							break;
+						}
+
+						case directory_entry_type::file:
+							add_file(node, path_buffer, prefix_length, entry.d_name, std::filesystem::file_type::regular);
+							break;
+
+						case directory_entry_type::symlink_to_file:
+							add_file(node, path_buffer, prefix_length, entry.d_name, std::filesystem::file_type::symlink);
+							break;
+
+						case directory_entry_type::other:
+							break;
+					}
+				}
+			}
+		}
+
+		void add_file(
+			directory_node& node,
+			std::string& path_buffer,
+			size_t prefix_length,
+			char const* name,
+			std::filesystem::file_type type
+		)
+		{
+			path_buffer.resize(prefix_length);
+			path_buffer += name;
+			if(!m_input_filter.may_accept(m_input_filter.object, path_buffer))
+			{ return; }
+
+			if(m_input_filter.accepts(m_input_filter.object, slideproj::file_collector::scanned_file{path_buffer, type}))
+			{
+				node.items.push_back(directory_item{
+					.file = path_buffer,
+					.subdirectory = nullptr
+				});
+			}
+		}
+
+		void push(size_t worker_index, directory_node& node)
+		{
+			{
+				auto& queue = m_queues[worker_index];
+				std::lock_guard lock{queue.mutex};
+				queue.tasks.push_back(&node);
+				++m_pending_tasks;
+				++m_queued_tasks;
+			}
+			std::lock_guard lock{m_idle_mutex};
+			m_idle_cv.notify_one();
+		}
+
+		directory_node* pop(size_t worker_index)
+		{
+			// Take the most recent task from the own queue, to keep the traversal depth-first
+			auto& queue = m_queues[worker_index];
+			std::lock_guard lock{queue.mutex};
+			if(queue.tasks.empty())
+			{ return nullptr; }
+
+			auto const ret = queue.tasks.back();
+			queue.tasks.pop_back();
+			--m_queued_tasks;
+			return ret;
+		}
+
+		directory_node* steal(size_t worker_index)
+		{
+			// Take the oldest task from another queue. It is likely to be close to the root, and
+			// therefore represent more work.
+			auto& queue = m_queues[worker_index];
+			std::lock_guard lock{queue.mutex};
+			if(queue.tasks.empty())
+			{ return nullptr; }
+
+			auto const ret = queue.tasks.front();
+			queue.tasks.pop_front();
+			--m_queued_tasks;
+			return ret;
+		}
+
+		directory_node* next_task(size_t worker_index)
+		{
+			while(true)
+			{
+				if(auto const ret = pop(worker_index); ret != nullptr)
+				{ return ret; }
+
+				for(size_t k = 1; k != std::size(m_queues); ++k)
+				{
+					if(auto const ret = steal((worker_index + k)%std::size(m_queues)); ret != nullptr)
+					{ return ret; }
+				}
+
+				std::unique_lock lock{m_idle_mutex};
+				m_idle_cv.wait(lock, [this](){
+					return m_queued_tasks != 0 || m_pending_tasks == 0 || m_failed;
+				});
+
+				if(m_pending_tasks == 0 || m_failed)
+				{ return nullptr; }
+			}
+		}
+
+		void task_done()
+		{
+			if(--m_pending_tasks == 0)
+			{
+				std::lock_guard lock{m_idle_mutex};
+				m_idle_cv.notify_all();
+			}
+		}
+
+		void set_error(std::exception_ptr error)
+		{
+			std::lock_guard lock{m_idle_mutex};
+			if(!m_error)
+			{ m_error = error; }
+			m_failed = true;
+			m_idle_cv.notify_all();
+		}
+
+		slideproj::file_collector::type_erased_input_filter m_input_filter;
+		std::vector<worker_queue> m_queues;
+		std::atomic<size_t> m_pending_tasks{0};
+		std::atomic<size_t> m_queued_tasks{0};
+		std::atomic<bool> m_failed{false};
+		std::mutex m_idle_mutex;
+		std::condition_variable m_idle_cv;
+		std::exception_ptr m_error;
+	};
+
+	void append_files(slideproj::file_collector::file_list& ret, directory_node const& node)
+	{
+		for(auto const& item : node.items)
+		{
+			if(item.subdirectory != nullptr)
+			{ append_files(ret, *item.subdirectory); }
+			else
+			{ ret.append(item.file); }
+		}
+	}
+}
+
 slideproj::file_collector::file_list
 slideproj::file_collector::make_file_list(
 	std::vector<std::string> const& input_directories,
-	type_erased_input_filter input_filter
+	type_erased_input_filter input_filter,
+	size_t worker_count
 )
 {
+	std::vector<directory_node> roots;
+	std::ranges::transform(input_directories, std::back_inserter(roots), [](auto const& item){
+		return directory_node{
+			.path = item,
+			.parent = nullptr,
+			.items = {}
+		};
+	});
+
+	directory_scanner{input_filter, worker_count}.scan(roots);
+
+	// Assemble the result in the same order as a depth-first traversal would produce, so the
+	// output does not depend on how directories were distributed among the workers
 	file_list ret;
-	namespace fs = std::filesystem;
-	using diropts = fs::directory_options;
-	using dir_iter = fs::recursive_directory_iterator;
-	for(auto const& item :input_directories)
+	for(auto const& item : roots)
+	{ append_files(ret, item); }
+
+	return ret;
+}
+
+std::string slideproj::file_collector::make_locale_collation_key(std::string const& str)
+{
+	std::string ret;
+	ret.resize(strxfrm(nullptr, str.c_str(), 0));
+	// NOTE: Writing the null terminator to ret[size()] is allowed
+	strxfrm(std::data(ret), str.c_str(), std::size(ret) + 1);
+	return ret;
+}
+
+namespace
+{
+	void append_key(std::string& key, slideproj::file_collector::file_clock::time_point value)
 	{
-		for (auto const& dir_entry : dir_iter{item, diropts::skip_permission_denied})
+		// Flip the sign bit, and store big endian, so that memcmp gives the same order as comparing
+		// the signed value
+		using rep = slideproj::file_collector::file_clock::rep;
+		auto const bits = static_cast<unsigned __int128>(value.time_since_epoch().count())
+			^ (static_cast<unsigned __int128>(1) << (8*sizeof(rep) - 1));
+		for(size_t k = sizeof(rep); k != 0; --k)
+		{ key.push_back(static_cast<char>(static_cast<uint8_t>(bits >> (8*(k - 1))))); }
+	}
+
+	void append_key(
+		std::string& key,
+		std::string_view value,
+		slideproj::file_collector::type_erased_collation_key_generator key_generator
+	)
+	{
+		// NOTE: The terminator makes sure that a key that is a prefix of another key compares less,
+		//       also when more fields follow
+		key.append(key_generator.make_key(key_generator.object, std::string{value}));
+		key.push_back('\0');
+	}
+
+	std::string make_sort_key(
+		slideproj::file_collector::file_metadata const& metadata,
+		std::span<slideproj::file_collector::file_metadata_field const> sort_by,
+		slideproj::file_collector::type_erased_collation_key_generator key_generator
+	)
+	{
+		using slideproj::file_collector::file_metadata_field;
+		std::string ret;
+		for(auto field : sort_by)
 		{
-			// For now, only store regular files. Directories could be useful to generate automatic
-			// title screens
-			if(dir_entry.is_regular_file() && input_filter.accepts(input_filter.object, dir_entry))
-			{ ret.append(dir_entry.path()); }
+			switch(field)
+			{
+				case file_metadata_field::timestamp:
+					append_key(ret, metadata.timestamp);
+					break;
+				case file_metadata_field::in_group:
+					append_key(ret, metadata.in_group, key_generator);
+					break;
+				case file_metadata_field::caption:
+					append_key(ret, metadata.caption, key_generator);
+					break;
+			}
 		}
+		return ret;
 	}
-
-	return ret;
 }
 
 void slideproj::file_collector::sort(
 	file_list& files,
 	std::span<file_metadata_field const> sort_by,
 	type_erased_file_metadata_provider metadata_provider,
-	type_erased_string_comparator string_comparator
+	type_erased_collation_key_generator key_generator,
+	size_t worker_count
 )
 {
-	files.sort(
-		[
-			sort_by,
-			metadata_provider,
-			string_comparator
-		](file_list_entry const& a, file_list_entry const& b) {
-			auto const& metadata_a = metadata_provider.get_metadata(metadata_provider.object, a);
-			auto const& metadata_b = metadata_provider.get_metadata(metadata_provider.object, b);
-			auto strcmp = [string_comparator](std::string const& a, std::string const& b){
-				return string_comparator.compare(string_comparator.object, a, b);
-			};
-			for(auto field:sort_by)
-			{
-				auto const res = compare_field(field, metadata_a, metadata_b, strcmp);
-				if(res < 0)
-				{ return true; }
-				if(res > 0)
-				{ return false;}
-			}
-			return false;
+	if(std::size(files) == 0)
+	{ return; }
+
+	// NOTE: Only key generation runs in parallel. The sort itself is sequential, since a parallel
+	//       std::sort requires TBB with libstdc++.
+	auto const max_id = std::ranges::max(files, {}, [](auto const& item){ return item.id().value(); }).id();
+	std::vector<std::string> keys(max_id.value() + 1);
+	utils::parallel_for(
+		std::size(files),
+		worker_count,
+		[&files, &keys, sort_by, metadata_provider, key_generator](size_t k) {
+			auto const& entry = *(std::begin(files) + static_cast<ptrdiff_t>(k));
+			keys[entry.id().value()] = make_sort_key(
+				metadata_provider.get_metadata(metadata_provider.object, entry),
+				sort_by,
+				key_generator
+			);
 		}
 	);
+
+	files.sort([&keys](file_list_entry const& a, file_list_entry const& b) {
+		return keys[a.id().value()] < keys[b.id().value()];
+	});
 }
 
 std::optional<slideproj::file_collector::file_clock::time_point>
@@ -3,13 +3,19 @@
 #ifndef SLIDEPROJ_FILE_COLLECTOR_FILE_COLLECTOR_HPP
 #define SLIDEPROJ_FILE_COLLECTOR_FILE_COLLECTOR_HPP
 
+#include "src/utils/string_arena.hpp"
+
 #include <chrono>
+#include <string>
+#include <string_view>
 #include <linux/stat.h>
 #include <sys/stat.h>
 #include <vector>
 #include <algorithm>
 #include <filesystem>
 #include <functional>
+#include <iterator>
+#include <memory>
 
 namespace slideproj::file_collector
 {
@@ -37,7 +43,9 @@ namespace slideproj::file_collector
 	public:
 		file_list_entry() = default;
 
-		explicit file_list_entry(file_id id, std::filesystem::path const& path):
+		// NOTE: The entry does not own the path. Entries returned by a file_list refer to the path
+		//       storage of that file_list, and are valid as long as the file_list exists.
+		explicit file_list_entry(file_id id, std::string_view path):
 			m_id{id}, m_path{path}
 		{}
 
@@ -45,6 +53,9 @@ namespace slideproj::file_collector
 		{ return m_id; }
 
 		std::filesystem::path path() const
+		{ return std::filesystem::path{m_path}; }
+
+		std::string_view path_string() const
 		{ return m_path; }
 
 		bool operator==(file_list_entry const&) const = default;
@@ -52,12 +63,16 @@ namespace slideproj::file_collector
 
 	private:
 		file_id m_id;
-		std::filesystem::path m_path;
+		std::string_view m_path;
 	};
 
 	class file_list
 	{
 	public:
+		file_list() = default;
+		file_list(file_list&&) = default;
+		file_list& operator=(file_list&&) = default;
+
 		size_t size() const
 		{ return std::size(m_entries); }
 
@@ -74,13 +89,40 @@ namespace slideproj::file_collector
 			return *this;
 		}
 
-		file_list& append(std::filesystem::path const& path)
+		file_list& append(std::string_view path)
+		{ return append_unowned(m_paths.insert(path)); }
+
+		// NOTE: The path is not copied. The caller must make sure that it outlives the file_list, for
+		//       example by handing over its storage to keep_alive.
+		file_list& append_unowned(std::string_view path)
 		{
 			file_id new_id{size()};
 			m_entries.push_back(file_list_entry{new_id, path});
 			return *this;
 		}
 
+		// NOTE: Entries from other get new ids, continuing from the last entry in this list
+		file_list& append(file_list&& other)
+		{
+			for(auto const& item : other.m_entries)
+			{ append_unowned(item.path_string()); }
+
+			keep_alive(std::make_shared<utils::string_arena const>(std::move(other.m_paths)));
+			std::ranges::move(other.m_external_storage, std::back_inserter(m_external_storage));
+			other.m_external_storage.clear();
+			other.m_entries.clear();
+			return *this;
+		}
+
+		file_list& keep_alive(std::shared_ptr<void const> storage)
+		{
+			m_external_storage.push_back(std::move(storage));
+			return *this;
+		}
+
+		void reserve(size_t count)
+		{ m_entries.reserve(count); }
+
 		bool empty() const
 		{ return m_entries.empty(); }
 
@@ -92,38 +134,68 @@ namespace slideproj::file_collector
 		}
 
 	private:
+		utils::string_arena m_paths;
+		std::vector<std::shared_ptr<void const>> m_external_storage;
 		std::vector<file_list_entry> m_entries;
 	};
 
+	// A file found by make_file_list. The type is taken from the directory entry, and is either
+	// regular, or symlink for a symlink that refers to a regular file.
+	struct scanned_file
+	{
+		std::string_view path;
+		std::filesystem::file_type type;
+	};
+
+	// NOTE: make_file_list may call accepts from several threads at once
 	template<class T>
-	concept input_filter = requires(T const& obj, std::filesystem::directory_entry const& item){
+	concept input_filter = requires(T const& obj, scanned_file const& item){
 		{obj.accepts(item)} -> std::same_as<bool>;
 	};
 
+	// An input filter may provide a cheap test on the path string alone. It is used to reject files
+	// before any std::filesystem object is created for them. If the filter has may_accept,
+	// make_file_list only calls accepts for files that have passed it.
+	template<class T>
+	concept input_prefilter = requires(T const& obj, std::string_view path){
+		{obj.may_accept(path)} -> std::same_as<bool>;
+	};
+
 	struct type_erased_input_filter{
 		void const* object;
-		bool (*accepts)(void const*, std::filesystem::directory_entry const&);
+		bool (*may_accept)(void const*, std::string_view);
+		bool (*accepts)(void const*, scanned_file const&);
 	};
 
 	file_list make_file_list(
 		std::vector<std::string> const& input_directories,
-		type_erased_input_filter input_filter
+		type_erased_input_filter input_filter,
+		size_t worker_count = 1
 	);
 
 	template<input_filter InputFilter>
 	file_list make_file_list(
 		std::vector<std::string> const& input_directories,
-		InputFilter&& input_filter
+		InputFilter&& input_filter,
+		size_t worker_count = 1
 	)
 	{
+		using filter_type = std::remove_cvref_t<InputFilter>;
 		return make_file_list(
 			input_directories,
 			type_erased_input_filter{
 				.object = &input_filter,
-				.accepts = [](void const* obj, std::filesystem::directory_entry const& entry){
-					return static_cast<InputFilter const*>(obj)->accepts(entry);
+				.may_accept = [](void const* obj, std::string_view path){
+					if constexpr(input_prefilter<filter_type>)
+					{ return static_cast<filter_type const*>(obj)->may_accept(path); }
+					else
+					{ return true; }
+				},
+				.accepts = [](void const* obj, scanned_file const& item){
+					return static_cast<filter_type const*>(obj)->accepts(item);
 				}
-			}
+			},
+			worker_count
 		);
 	}
 
@@ -151,73 +223,58 @@ namespace slideproj::file_collector
 		}
 	};
 
+	// NOTE: The strings refer to storage owned by the metadata provider
 	struct file_metadata
 	{
 		file_clock::time_point timestamp;
-		std::string in_group;
-		std::string caption;
+		std::string_view in_group;
+		std::string_view caption;
 	};
 
 	template<class T>
-	concept string_comparator = requires(
-		T const& obj,
-		std::string const& a,
-		std::string const& b
-	){
-		{obj(a, b)} -> std::same_as<std::strong_ordering>;
+	concept collation_key_generator = requires(T const& obj, std::string const& str){
+		{obj(str)} -> std::same_as<std::string>;
 	};
 
-	template<string_comparator StringComparator>
-	inline auto compare_field(
-		file_metadata_field field,
-		file_metadata const& a,
-		file_metadata const& b,
-		StringComparator const& strcmp
-	)
-	{
-		switch(field)
-		{
-			case file_metadata_field::timestamp:
-				return a.timestamp <=> b.timestamp;
-			case file_metadata_field::in_group:
-				return strcmp(a.in_group, b.in_group);
-			case file_metadata_field::caption:
-				return strcmp(a.caption, b.caption);
-		}
-		__builtin_unreachable();
-	}
+	// NOTE: Comparing two keys with strcmp gives the same result as strcoll on the original strings
+	std::string make_locale_collation_key(std::string const& str);
 
 	template<class T>
 	concept file_metadata_provider = requires(T const& obj, file_list_entry const& item){
-		{obj.get_metadata(item)} -> std::convertible_to<file_metadata const&>;
+		{obj.get_metadata(item)} -> std::convertible_to<file_metadata>;
 	};
 
 	struct type_erased_file_metadata_provider{
 		void const* object;
-		file_metadata const& (*get_metadata)(void const*, file_list_entry const&);
+		file_metadata (*get_metadata)(void const*, file_list_entry const&);
 	};
 
-	struct type_erased_string_comparator{
+	struct type_erased_collation_key_generator{
 		void const* object;
-		std::strong_ordering (*compare)(void const*, std::string const&, std::string const&);
+		std::string (*make_key)(void const*, std::string const&);
 	};
 
+	// NOTE: Instead of comparing strings during the sort, a key is built once per entry from its
+	//       metadata. Keys are then compared with memcmp. Keys are built using worker_count threads.
+	//       This means that get_metadata and the key generator may be called concurrently.
 	void sort(
 		file_list& files,
 		std::span<file_metadata_field const> sort_by,
 		type_erased_file_metadata_provider metadata_provider,
-		type_erased_string_comparator string_comparator
+		type_erased_collation_key_generator key_generator,
+		size_t worker_count = 1
 	);
 
 	template<
 		file_metadata_provider FileMetadataProvider,
-		string_comparator StringComparator
+		collation_key_generator CollationKeyGenerator
 	>
 	void sort(
 		file_list& files,
 		std::span<file_metadata_field const> sort_by,
 		FileMetadataProvider const& metadata_provider,
-		StringComparator const& string_comparator
+		CollationKeyGenerator const& key_generator,
+		size_t worker_count = 1
 	)
 	{
 		sort(
@@ -225,34 +282,36 @@ namespace slideproj::file_collector
 			sort_by,
 			type_erased_file_metadata_provider{
 				.object = &metadata_provider,
-				.get_metadata = [](void const* handle, file_list_entry const& item) -> file_metadata const& {
+				.get_metadata = [](void const* handle, file_list_entry const& item) -> file_metadata {
 					return static_cast<FileMetadataProvider const*>(handle)->get_metadata(item);
 				}
 			},
-			type_erased_string_comparator{
-				.object = &string_comparator,
-				.compare = [](void const* handle, std::string const& a, std::string const& b) {
-					return (*static_cast<StringComparator const*>(handle))(a, b);
+			type_erased_collation_key_generator{
+				.object = &key_generator,
+				.make_key = [](void const* handle, std::string const& str) {
+					return (*static_cast<CollationKeyGenerator const*>(handle))(str);
 				}
-			}
+			},
+			worker_count
 		);
 	}
 
 	template<
 		input_filter InputFilter,
 		file_metadata_provider FileMetadataProvider,
-		string_comparator StringComparator
+		collation_key_generator CollationKeyGenerator
 	>
 	inline file_list make_file_list(
 		std::vector<std::string> const& input_directories,
 		InputFilter&& input_filter,
 		std::span<file_metadata_field const> sort_by,
 		FileMetadataProvider const& metadata_provider,
-		StringComparator const& string_comparator
+		CollationKeyGenerator const& key_generator,
+		size_t worker_count = 1
 	)
 	{
-		auto ret = make_file_list(input_directories, std::forward<InputFilter>(input_filter));
-		sort(ret, sort_by, metadata_provider, string_comparator);
+		auto ret = make_file_list(input_directories, std::forward<InputFilter>(input_filter), worker_count);
+		sort(ret, sort_by, metadata_provider, key_generator, worker_count);
 		return ret;
 	}
 
@@ -6,8 +6,15 @@
 #include "testfwk/validation.hpp"
 
 #include <array>
+#include <cstring>
 #include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
 #include <unordered_map>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <tuple>
 
 TESTCASE(slideproj_file_collector_file_list_load_and_sort)
 {
@@ -91,26 +98,40 @@ namespace
 			slideproj::file_collector::file_clock::time_point{std::chrono::seconds{1671563660}}
 		};
 
-		file_metadata const& get_metadata(slideproj::file_collector::file_list_entry const& item) const
+		struct stored_metadata
 		{
-			auto const i = values.find(item.id());
-			if(i != std::end(values))
-			{ return i->second; }
-
-			auto const ip = values.insert(
-				std::pair{
-					item.id(),
-					file_metadata{
-						.timestamp = random_timestamps[item.id().value()],
-						.in_group = item.path().parent_path(),
-						.caption = item.path().filename()
+			slideproj::file_collector::file_clock::time_point timestamp;
+			std::string in_group;
+			std::string caption;
+		};
+
+		file_metadata get_metadata(slideproj::file_collector::file_list_entry const& item) const
+		{
+			std::lock_guard lock{mtx};
+			auto i = values.find(item.id());
+			if(i == std::end(values))
+			{
+				i = values.insert(
+					std::pair{
+						item.id(),
+						stored_metadata{
+							.timestamp = random_timestamps[item.id().value()],
+							.in_group = item.path().parent_path(),
+							.caption = item.path().filename()
+						}
 					}
-				}
-			);
-			return ip.first->second;
+				).first;
+			}
+
+			return file_metadata{
+				.timestamp = i->second.timestamp,
+				.in_group = i->second.in_group,
+				.caption = i->second.caption
+			};
 		}
 
-		mutable std::unordered_map<file_id, file_metadata> values;
+		mutable std::mutex mtx;
+		mutable std::unordered_map<file_id, stored_metadata> values;
 	};
 }
 
@@ -132,7 +153,7 @@ TESTCASE(slideproj_file_collector_file_list_sort_with_metadata_provider)
 	};
 
 	for(auto const& item: input_files)
-	{ files.append(item);}
+	{ files.append(item.native());}
 	EXPECT_EQ(std::size(files), std::size(input_files));
 
 	using file_metadata_field = slideproj::file_collector::file_metadata_field;
@@ -142,8 +163,8 @@ TESTCASE(slideproj_file_collector_file_list_sort_with_metadata_provider)
 		files,
 		std::array{file_metadata_field::timestamp, file_metadata_field::in_group, file_metadata_field::caption},
 		metadata_provider,
-		[](std::string_view a, std::string_view b){
-			return a <=> b;
+		[](std::string const& str){
+			return str;
 		}
 	);
 
@@ -156,28 +177,138 @@ TESTCASE(slideproj_file_collector_file_list_sort_with_metadata_provider)
 	for(size_t k = 0; k != std::size(stored_ids); ++k)
 	{ EXPECT_EQ(stored_ids[k], k); }
 
-	auto prev_file_info = &metadata_provider.get_metadata(files[0]);
+	auto prev_file_info = metadata_provider.get_metadata(files[0]);
 	for(size_t k = 1; k != std::size(files); ++k)
 	{
-		auto current_file_info = &metadata_provider.get_metadata(files[k]);
-		EXPECT_GE(current_file_info->timestamp, prev_file_info->timestamp);
-		if(current_file_info->timestamp == prev_file_info->timestamp)
+		auto current_file_info = metadata_provider.get_metadata(files[k]);
+		EXPECT_GE(current_file_info.timestamp, prev_file_info.timestamp);
+		if(current_file_info.timestamp == prev_file_info.timestamp)
 		{
-			EXPECT_GE(current_file_info->in_group, prev_file_info->in_group);
-			if(current_file_info->in_group == prev_file_info->in_group)
-			{ EXPECT_GE(current_file_info->caption, prev_file_info->caption)}
+			EXPECT_GE(current_file_info.in_group, prev_file_info.in_group);
+			if(current_file_info.in_group == prev_file_info.in_group)
+			{ EXPECT_GE(current_file_info.caption, prev_file_info.caption)}
 		}
 		prev_file_info = current_file_info;
 	}
 }
 
+TESTCASE(slideproj_file_collector_file_list_sort_with_metadata_provider_multiple_workers)
+{
+	slideproj::file_collector::file_list files_a;
+	slideproj::file_collector::file_list files_b;
+	for(size_t k = 0; k != std::size(file_metadata_provider::random_timestamps); ++k)
+	{
+		auto const path = std::format("/home/sarah/Pictures/IMG_{}.jpg", k);
+		files_a.append(path);
+		files_b.append(path);
+	}
+
+	using file_metadata_field = slideproj::file_collector::file_metadata_field;
+	std::array const sort_by{file_metadata_field::timestamp, file_metadata_field::caption};
+	auto const make_key = [](std::string const& str){
+		return str;
+	};
+
+	file_metadata_provider metadata_provider_a{};
+	sort(files_a, sort_by, metadata_provider_a, make_key, 1);
+	file_metadata_provider metadata_provider_b{};
+	sort(files_b, sort_by, metadata_provider_b, make_key, 4);
+
+	EXPECT_EQ(std::size(metadata_provider_b.values), std::size(files_b));
+	EXPECT_EQ(std::ranges::equal(files_a, files_b), true);
+}
+
+TESTCASE(slideproj_file_collector_file_list_sort_with_collation_keys)
+{
+	slideproj::file_collector::file_list files_a;
+	slideproj::file_collector::file_list files_b;
+	for(size_t k = 0; k != std::size(file_metadata_provider::random_timestamps); ++k)
+	{
+		auto const path = std::format("/home/sarah/Pictures/{}/IMG_{}.jpg", k%3 == 0? "a" : "ab", k%4);
+		files_a.append(path);
+		files_b.append(path);
+	}
+
+	using file_metadata_field = slideproj::file_collector::file_metadata_field;
+	std::array const sort_by{
+		file_metadata_field::in_group,
+		file_metadata_field::caption,
+		file_metadata_field::timestamp
+	};
+
+	// NOTE: Sort files_a by comparing the fields directly, to check the encoding of the keys
+	file_metadata_provider metadata_provider_a{};
+	files_a.sort([&metadata_provider_a](auto const& a, auto const& b){
+		auto const metadata_a = metadata_provider_a.get_metadata(a);
+		auto const metadata_b = metadata_provider_a.get_metadata(b);
+		return std::tie(metadata_a.in_group, metadata_a.caption, metadata_a.timestamp)
+			< std::tie(metadata_b.in_group, metadata_b.caption, metadata_b.timestamp);
+	});
+	file_metadata_provider metadata_provider_b{};
+	sort(files_b, sort_by, metadata_provider_b, [](std::string const& str){
+		return str;
+	}, 4);
+
+	EXPECT_EQ(std::ranges::equal(files_a, files_b), true);
+}
+
+TESTCASE(slideproj_file_collector_make_locale_collation_key)
+{
+	std::array const strings{"", "a", "A", "ab", "b", "B", "a b", "a-b", "IMG_0001", "img_0002"};
+	for(std::string a : strings)
+	{
+		for(std::string b : strings)
+		{
+			auto const key_a = slideproj::file_collector::make_locale_collation_key(a);
+			auto const key_b = slideproj::file_collector::make_locale_collation_key(b);
+			EXPECT_EQ(strcmp(key_a.c_str(), key_b.c_str()) < 0, strcoll(a.c_str(), b.c_str()) < 0);
+			EXPECT_EQ(strcmp(key_a.c_str(), key_b.c_str()) == 0, strcoll(a.c_str(), b.c_str()) == 0);
+		}
+	}
+}
+
 namespace
 {
 	struct input_filter
 	{
-		bool accepts(std::filesystem::directory_entry const&) const
+		bool accepts(slideproj::file_collector::scanned_file const&) const
 		{ return true; }
 	};
+
+	struct recording_input_filter
+	{
+		bool accepts(slideproj::file_collector::scanned_file const& item) const
+		{
+			std::lock_guard lock{mutex};
+			types.emplace(item.path, item.type);
+			return true;
+		}
+
+		mutable std::mutex mutex;
+		mutable std::unordered_map<std::string, std::filesystem::file_type> types;
+	};
+
+	std::filesystem::path make_empty_directory(char const* name)
+	{
+		auto const ret = std::filesystem::temp_directory_path()/name;
+		std::filesystem::remove_all(ret);
+		std::filesystem::create_directories(ret);
+		return ret;
+	}
+
+	void create_file(std::filesystem::path const& path)
+	{
+		std::filesystem::create_directories(path.parent_path());
+		std::ofstream{path};
+	}
+
+	std::vector<std::string> get_paths(slideproj::file_collector::file_list const& files)
+	{
+		std::vector<std::string> ret;
+		for(auto const& item : files)
+		{ ret.push_back(std::string{item.path_string()}); }
+		return ret;
+	}
 }
 
 TESTCASE(slideproj_file_collector_make_real_file_list)
@@ -186,3 +317,148 @@ TESTCASE(slideproj_file_collector_make_real_file_list)
 	for(auto const& item: files)
 	{ EXPECT_EQ(item.path().is_absolute(), false); }
 }
+
+TESTCASE(slideproj_file_collector_make_real_file_list_multiple_workers)
+{
+	std::vector<std::string> const input_directories{"testdata", "src"};
+	auto const files_a = slideproj::file_collector::make_file_list(input_directories, input_filter{}, 1);
+	auto const files_b = slideproj::file_collector::make_file_list(input_directories, input_filter{}, 4);
+	REQUIRE_EQ(std::size(files_a), std::size(files_b));
+	for(size_t k = 0; k != std::size(files_a); ++k)
+	{ EXPECT_EQ(files_a[k], files_b[k]); }
+}
+
+TESTCASE(slideproj_file_collector_make_file_list_nested_directories)
+{
+	auto const root = make_empty_directory("slideproj_file_collector_test_nested");
+	create_file(root/"a.jpg");
+	create_file(root/"x/b.jpg");
+	create_file(root/"x/y/c.jpg");
+	create_file(root/"x/y/z/d.jpg");
+	std::filesystem::create_directories(root/"empty");
+
+	auto files = get_paths(
+		slideproj::file_collector::make_file_list(std::vector<std::string>{root.native()}, input_filter{})
+	);
+	std::ranges::sort(files);
+	EXPECT_EQ(
+		files,
+		(std::vector<std::string>{
+			(root/"a.jpg").native(),
+			(root/"x/b.jpg").native(),
+			(root/"x/y/c.jpg").native(),
+			(root/"x/y/z/d.jpg").native()
+		})
+	);
+}
+
+TESTCASE(slideproj_file_collector_make_file_list_symlinks)
+{
+	auto const root = make_empty_directory("slideproj_file_collector_test_symlinks");
+	create_file(root/"dir/a.jpg");
+	std::filesystem::create_symlink("dir/a.jpg", root/"link_to_file.jpg");
+	std::filesystem::create_directory_symlink("dir", root/"link_to_dir");
+	std::filesystem::create_symlink("does_not_exist.jpg", root/"dangling.jpg");
+
+	// NOTE: Symlinks to directories are not followed, so dir/a.jpg is only found once
+	recording_input_filter filter;
+	auto files = get_paths(
+		slideproj::file_collector::make_file_list(std::vector<std::string>{root.native()}, filter)
+	);
+	std::ranges::sort(files);
+	EXPECT_EQ(
+		files,
+		(std::vector<std::string>{
+			(root/"dir/a.jpg").native(),
+			(root/"link_to_file.jpg").native()
+		})
+	);
+	EXPECT_EQ(filter.types.at((root/"dir/a.jpg").native()) == std::filesystem::file_type::regular, true);
+	EXPECT_EQ(filter.types.at((root/"link_to_file.jpg").native()) == std::filesystem::file_type::symlink, true);
+}
+
+TESTCASE(slideproj_file_collector_make_file_list_skip_unreadable_directory)
+{
+	auto const root = make_empty_directory("slideproj_file_collector_test_unreadable");
+	create_file(root/"a.jpg");
+	create_file(root/"locked/b.jpg");
+	std::filesystem::permissions(root/"locked", std::filesystem::perms::none);
+
+	auto files = get_paths(
+		slideproj::file_collector::make_file_list(std::vector<std::string>{root.native()}, input_filter{})
+	);
+	std::filesystem::permissions(root/"locked", std::filesystem::perms::owner_all);
+	std::ranges::sort(files);
+
+	// NOTE: Permissions do not apply to root
+	if(geteuid() == 0)
+	{ EXPECT_EQ(files, (std::vector<std::string>{(root/"a.jpg").native(), (root/"locked/b.jpg").native()})); }
+	else
+	{ EXPECT_EQ(files, (std::vector<std::string>{(root/"a.jpg").native()})); }
+}
+
+TESTCASE(slideproj_file_collector_make_file_list_missing_input_directory)
+{
+	auto const root = make_empty_directory("slideproj_file_collector_test_missing");
+	create_file(root/"a.jpg");
+
+	auto failed = false;
+	try
+	{
+		slideproj::file_collector::make_file_list(
+			std::vector<std::string>{root.native(), (root/"missing").native()},
+			input_filter{},
+			2
+		);
+	}
+	catch(std::runtime_error const&)
+	{ failed = true; }
+	EXPECT_EQ(failed, true);
+}
+
+TESTCASE(slideproj_file_collector_make_file_list_large_directory)
+{
+	// NOTE: With names this long, the entries do not fit in a single getdents64 buffer
+	auto const root = make_empty_directory("slideproj_file_collector_test_large");
+	std::vector<std::string> expected;
+	for(size_t k = 0; k != 8192; ++k)
+	{
+		auto const path = root/std::format("{:0>64}.jpg", k);
+		create_file(path);
+		expected.push_back(path.native());
+	}
+
+	auto files = get_paths(
+		slideproj::file_collector::make_file_list(std::vector<std::string>{root.native()}, input_filter{})
+	);
+	std::ranges::sort(files);
+	std::ranges::sort(expected);
+	EXPECT_EQ(files, expected);
+}
+
+TESTCASE(slideproj_file_collector_make_file_list_order_independent_of_worker_count)
+{
+	auto const root = make_empty_directory("slideproj_file_collector_test_order");
+	for(size_t k = 0; k != 16; ++k)
+	{
+		for(size_t l = 0; l != 4; ++l)
+		{
+			create_file(root/std::format("dir_{}/file_{}.jpg", k, l));
+			create_file(root/std::format("dir_{}/sub_{}/file.jpg", k, l));
+		}
+		create_file(root/std::format("file_{}.jpg", k));
+	}
+
+	std::vector<std::string> const input_directories{root.native(), (root/"dir_3").native()};
+	auto const expected = get_paths(
+		slideproj::file_collector::make_file_list(input_directories, input_filter{}, 1)
+	);
+	EXPECT_EQ(std::size(expected), 16*9 + 8);
+	for(size_t worker_count : {2, 3, 8})
+	{
+		auto const files = get_paths(
+			slideproj::file_collector::make_file_list(input_directories, input_filter{}, worker_count)
+		);
+		EXPECT_EQ(files, expected);
+	}
+}
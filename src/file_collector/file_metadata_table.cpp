@@ -0,0 +1,39 @@
+//@	{"target": {"name":"file_metadata_table.o"}}
+
+#include "./file_metadata_table.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+void slideproj::file_collector::file_metadata_table::insert(file_id id, file_metadata const& metadata)
+{
+	auto const index = id.value();
+	if(index >= std::size(m_present))
+	{
+		m_timestamps.resize(index + 1);
+		m_groups.resize(index + 1);
+		m_captions.resize(index + 1);
+		m_present.resize(index + 1);
+	}
+
+	m_timestamps[index] = metadata.timestamp;
+	m_groups[index] = intern(metadata.in_group);
+	m_captions[index] = intern(metadata.caption);
+	m_present[index] = true;
+}
+
+uint32_t slideproj::file_collector::file_metadata_table::intern(std::string_view str)
+{
+	auto const i = m_string_ids.find(str);
+	if(i != std::end(m_string_ids))
+	{ return i->second; }
+
+	if(std::size(m_strings) == std::numeric_limits<uint32_t>::max())
+	{ throw std::runtime_error{"Too many strings in file metadata table"}; }
+
+	auto const new_id = static_cast<uint32_t>(std::size(m_strings));
+	// NOTE: Nodes in m_string_ids are never moved, so it is safe to keep a view of the key
+	auto const ip = m_string_ids.insert(std::pair{std::string{str}, new_id});
+	m_strings.push_back(ip.first->first);
+	return new_id;
+}
@@ -0,0 +1,54 @@
+//@	{"dependencies_extra":[{"ref":"./file_metadata_table.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_FILE_COLLECTOR_FILE_METADATA_TABLE_HPP
+#define SLIDEPROJ_FILE_COLLECTOR_FILE_METADATA_TABLE_HPP
+
+#include "./file_collector.hpp"
+
+#include "src/utils/transparent_string_hash.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace slideproj::file_collector
+{
+	// NOTE: Metadata is stored column-wise, and indexed directly by file id. Strings are interned, so
+	//       all files in the same group share the same group name. Returned strings stay valid for
+	//       the lifetime of the table.
+	class file_metadata_table
+	{
+	public:
+		void insert(file_id id, file_metadata const& metadata);
+
+		std::optional<file_metadata> find(file_id id) const
+		{
+			auto const index = id.value();
+			if(index >= std::size(m_present) || !m_present[index])
+			{ return std::nullopt; }
+
+			return file_metadata{
+				.timestamp = m_timestamps[index],
+				.in_group = m_strings[m_groups[index]],
+				.caption = m_strings[m_captions[index]]
+			};
+		}
+
+		size_t string_count() const
+		{ return std::size(m_strings); }
+
+	private:
+		uint32_t intern(std::string_view str);
+
+		utils::string_lookup_table<uint32_t> m_string_ids;
+		std::vector<std::string_view> m_strings;
+
+		std::vector<file_clock::time_point> m_timestamps;
+		std::vector<uint32_t> m_groups;
+		std::vector<uint32_t> m_captions;
+		std::vector<bool> m_present;
+	};
+}
+
+#endif
@@ -0,0 +1,71 @@
+//@	{"target":{"name":"file_metadata_table.test"}}
+
+#include "./file_metadata_table.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+TESTCASE(slideproj_file_collector_file_metadata_table_insert_and_find)
+{
+	using slideproj::file_collector::file_clock;
+	using slideproj::file_collector::file_id;
+	slideproj::file_collector::file_metadata_table table;
+
+	table.insert(file_id{5}, slideproj::file_collector::file_metadata{
+		.timestamp = file_clock::time_point{std::chrono::seconds{1643220649}},
+		.in_group = "/home/sarah/Pictures",
+		.caption = "IMG_0001"
+	});
+	table.insert(file_id{1}, slideproj::file_collector::file_metadata{
+		.timestamp = file_clock::time_point{std::chrono::seconds{1692772825}},
+		.in_group = "/home/sarah/Pictures",
+		.caption = "IMG_0002"
+	});
+
+	EXPECT_EQ(table.find(file_id{0}).has_value(), false);
+	EXPECT_EQ(table.find(file_id{6}).has_value(), false);
+	EXPECT_EQ(table.find(file_id{1000}).has_value(), false);
+
+	auto const a = table.find(file_id{5});
+	REQUIRE_EQ(a.has_value(), true);
+	EXPECT_EQ(a->timestamp, file_clock::time_point{std::chrono::seconds{1643220649}});
+	EXPECT_EQ(a->in_group, "/home/sarah/Pictures");
+	EXPECT_EQ(a->caption, "IMG_0001");
+
+	auto const b = table.find(file_id{1});
+	REQUIRE_EQ(b.has_value(), true);
+	EXPECT_EQ(b->timestamp, file_clock::time_point{std::chrono::seconds{1692772825}});
+	EXPECT_EQ(b->caption, "IMG_0002");
+
+	// Group names are interned
+	EXPECT_EQ(std::data(a->in_group), std::data(b->in_group));
+	EXPECT_EQ(table.string_count(), 3);
+}
+
+TESTCASE(slideproj_file_collector_file_metadata_table_strings_are_stable)
+{
+	using slideproj::file_collector::file_id;
+	slideproj::file_collector::file_metadata_table table;
+	table.insert(file_id{0}, slideproj::file_collector::file_metadata{
+		.timestamp = {},
+		.in_group = "foo",
+		.caption = "bar"
+	});
+	auto const first = table.find(file_id{0});
+	REQUIRE_EQ(first.has_value(), true);
+
+	for(size_t k = 1; k != 4096; ++k)
+	{
+		auto const caption = std::to_string(k);
+		table.insert(file_id{k}, slideproj::file_collector::file_metadata{
+			.timestamp = {},
+			.in_group = "foo",
+			.caption = caption
+		});
+	}
+
+	EXPECT_EQ(first->in_group, "foo");
+	EXPECT_EQ(first->caption, "bar");
+	auto const last = table.find(file_id{4095});
+	REQUIRE_EQ(last.has_value(), true);
+	EXPECT_EQ(last->caption, "4095");
+}
@@ -0,0 +1,304 @@
+//@	{"target": {"name":"json_file_list.o"}}
+
+#include "./json_file_list.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr std::string_view jobinfo_key{"slideproj_create_jobinfo"};
+	constexpr std::string_view files_key{"files"};
+	constexpr size_t first_batch_size = 16;
+	constexpr size_t max_batch_size = 4096;
+
+	// Expected layout:
+	//
+	//   {
+	//     "slideproj_create_jobinfo": {"working_directory": "...", ...},
+	//     "files": [{"path": "..."}, ...]
+	//   }
+	//
+	// The jobinfo is small, and is collected into a DOM. Entries in "files" are handled as they are
+	// parsed. Other values are skipped.
+	class json_file_list_sax_handler
+	{
+	public:
+		using json = nlohmann::json;
+
+		explicit json_file_list_sax_handler(
+			slideproj::file_collector::type_erased_json_file_list_consumer consumer
+		):m_consumer{consumer}
+		{}
+
+		bool null()
+		{ return value(nullptr); }
+
+		bool boolean(bool val)
+		{ return value(val); }
+
+		bool number_integer(json::number_integer_t val)
+		{ return value(val); }
+
+		bool number_unsigned(json::number_unsigned_t val)
+		{ return value(val); }
+
+		bool number_float(json::number_float_t val, json::string_t const&)
+		{ return value(val); }
+
+		bool binary(json::binary_t& val)
+		{ return value(std::move(val)); }
+
+		bool string(json::string_t& val)
+		{
+			if(m_dom_stack.empty() && is_entry_path())
+			{
+				m_entry_path = std::move(val);
+				return m_keep_going;
+			}
+			return value(std::move(val));
+		}
+
+		bool start_object(size_t)
+		{ return start_container(json::object()); }
+
+		bool start_array(size_t)
+		{ return start_container(json::array()); }
+
+		bool end_object()
+		{
+			if(!m_dom_stack.empty())
+			{ return end_dom_container(); }
+
+			--m_depth;
+			if(m_depth == 2 && m_in_entry)
+			{
+				m_in_entry = false;
+				if(m_entry_path.has_value())
+				{ add_path(std::move(*m_entry_path)); }
+			}
+			return m_keep_going;
+		}
+
+		bool end_array()
+		{
+			if(!m_dom_stack.empty())
+			{ return end_dom_container(); }
+
+			--m_depth;
+			if(m_depth == 1)
+			{ m_in_files = false; }
+			return m_keep_going;
+		}
+
+		bool key(json::string_t& val)
+		{
+			if(!m_dom_stack.empty())
+			{ m_dom_key = std::move(val); }
+			else
+			if(m_depth == 1)
+			{ m_top_level_key = std::move(val); }
+			else
+			if(m_depth == 3 && m_in_entry)
+			{ m_entry_key = std::move(val); }
+			return true;
+		}
+
+		bool parse_error(size_t, std::string const&, json::exception const& err)
+		{ throw std::runtime_error{std::format("Failed to parse file list: {}", err.what())}; }
+
+		void finish()
+		{
+			if(!m_working_directory.has_value())
+			{ throw std::runtime_error{"Missing slideproj jobinfo"}; }
+
+			if(!m_files_found)
+			{ throw std::runtime_error{"No file list present in the input"}; }
+
+			flush();
+		}
+
+		bool keep_going() const
+		{ return m_keep_going; }
+
+	private:
+		bool is_entry_path() const
+		{ return m_depth == 3 && m_in_entry && m_entry_key == "path"; }
+
+		template<class T>
+		bool value(T&& val)
+		{
+			if(!m_dom_stack.empty())
+			{
+				add_to_dom(std::forward<T>(val));
+				return m_keep_going;
+			}
+
+			if(m_depth == 1)
+			{
+				if(m_top_level_key == files_key)
+				{ throw std::runtime_error{"The list of files should be an array"}; }
+
+				if(m_top_level_key == jobinfo_key)
+				{
+					m_jobinfo = json(std::forward<T>(val));
+					set_jobinfo();
+				}
+			}
+			else
+			if(is_entry_path())
+			{ m_entry_path.reset(); }
+
+			return m_keep_going;
+		}
+
+		bool start_container(json&& container)
+		{
+			if(!m_dom_stack.empty())
+			{
+				m_dom_stack.push_back(&add_to_dom(std::move(container)));
+				return m_keep_going;
+			}
+
+			if(m_depth == 1)
+			{
+				if(m_top_level_key == jobinfo_key)
+				{
+					m_jobinfo = std::move(container);
+					m_dom_stack.push_back(&m_jobinfo);
+					return m_keep_going;
+				}
+
+				if(m_top_level_key == files_key)
+				{
+					if(!container.is_array())
+					{ throw std::runtime_error{"The list of files should be an array"}; }
+					m_in_files = true;
+					m_files_found = true;
+				}
+			}
+			else
+			if(m_depth == 2 && m_in_files && container.is_object())
+			{
+				m_in_entry = true;
+				m_entry_key.clear();
+				m_entry_path.reset();
+			}
+			else
+			if(is_entry_path())
+			{ m_entry_path.reset(); }
+
+			++m_depth;
+			return m_keep_going;
+		}
+
+		bool end_dom_container()
+		{
+			m_dom_stack.pop_back();
+			if(m_dom_stack.empty())
+			{ set_jobinfo(); }
+			return m_keep_going;
+		}
+
+		template<class T>
+		json& add_to_dom(T&& val)
+		{
+			auto& parent = *m_dom_stack.back();
+			if(parent.is_object())
+			{ return parent[m_dom_key] = json(std::forward<T>(val)); }
+
+			parent.push_back(json(std::forward<T>(val)));
+			return parent.back();
+		}
+
+		void set_jobinfo()
+		{
+			auto const wdi = m_jobinfo.is_object()? m_jobinfo.find("working_directory") : m_jobinfo.end();
+			if(wdi == std::end(m_jobinfo))
+			{ throw std::runtime_error{"Field working_directory is missing from jobinfo"}; }
+
+			auto const working_directory_ptr = wdi->get_ptr<json::string_t const*>();
+			if(working_directory_ptr == nullptr)
+			{ throw std::runtime_error{"Field working_directory must be a string"}; }
+
+			m_working_directory = std::filesystem::path{*working_directory_ptr};
+			m_consumer.set_jobinfo(m_consumer.object, std::move(m_jobinfo));
+			m_jobinfo = json{};
+
+			auto unresolved_paths = std::move(m_unresolved_paths);
+			for(auto& item : unresolved_paths)
+			{ add_path(std::move(item)); }
+		}
+
+		void add_path(std::string&& path)
+		{
+			if(!m_working_directory.has_value())
+			{
+				m_unresolved_paths.push_back(std::move(path));
+				return;
+			}
+
+			// NOTE: Files may have been removed or renamed since the list was created. These are
+			//       skipped, so the rest of the list can still be shown.
+			std::error_code ec;
+			auto const resolved_path = canonical(*m_working_directory/path, ec);
+			if(ec)
+			{
+				fprintf(stderr, "(!) Skipping %s: %s\n", path.c_str(), ec.message().c_str());
+				return;
+			}
+
+			m_batch.append(resolved_path.native());
+			if(std::size(m_batch) >= m_batch_size)
+			{
+				flush();
+				m_batch_size = std::min(2*m_batch_size, max_batch_size);
+			}
+		}
+
+		void flush()
+		{
+			if(m_batch.empty() || !m_keep_going)
+			{ return; }
+
+			m_keep_going = m_consumer.append(m_consumer.object, std::move(m_batch));
+			m_batch = slideproj::file_collector::file_list{};
+		}
+
+		slideproj::file_collector::type_erased_json_file_list_consumer m_consumer;
+
+		size_t m_depth{0};
+		std::string m_top_level_key;
+		bool m_in_files{false};
+		bool m_files_found{false};
+		bool m_in_entry{false};
+		std::string m_entry_key;
+		std::optional<std::string> m_entry_path;
+
+		json m_jobinfo;
+		std::vector<json*> m_dom_stack;
+		std::string m_dom_key;
+
+		std::optional<std::filesystem::path> m_working_directory;
+		std::vector<std::string> m_unresolved_paths;
+		slideproj::file_collector::file_list m_batch;
+		size_t m_batch_size{first_batch_size};
+		bool m_keep_going{true};
+	};
+}
+
+void slideproj::file_collector::load_json_file_list(
+	std::span<char const> data,
+	type_erased_json_file_list_consumer consumer
+)
+{
+	json_file_list_sax_handler handler{consumer};
+	nlohmann::json::sax_parse(std::begin(data), std::end(data), &handler);
+	if(handler.keep_going())
+	{ handler.finish(); }
+}
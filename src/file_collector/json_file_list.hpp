@@ -0,0 +1,53 @@
+//@	{"dependencies_extra":[{"ref":"./json_file_list.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_FILE_COLLECTOR_JSON_FILE_LIST_HPP
+#define SLIDEPROJ_FILE_COLLECTOR_JSON_FILE_LIST_HPP
+
+#include "./file_collector.hpp"
+
+#include <nlohmann/json.hpp>
+#include <span>
+
+namespace slideproj::file_collector
+{
+	template<class T>
+	concept json_file_list_consumer = requires(T& obj, nlohmann::json&& jobinfo, file_list&& files){
+		{obj.set_jobinfo(std::move(jobinfo))} -> std::same_as<void>;
+		{obj.append(std::move(files))} -> std::same_as<bool>;
+	};
+
+	struct type_erased_json_file_list_consumer
+	{
+		void* object;
+		void (*set_jobinfo)(void*, nlohmann::json&&);
+		bool (*append)(void*, file_list&&);
+	};
+
+	// The file list is parsed as a stream, so the document is never held in memory as a whole.
+	// Paths are resolved against the working directory from the jobinfo, and handed to the consumer
+	// in batches of increasing size. Paths that cannot be resolved are skipped. Loading stops early
+	// if append returns false.
+	//
+	// NOTE: If files are written before the jobinfo, paths have to be buffered until the working
+	//       directory is known.
+	void load_json_file_list(std::span<char const> data, type_erased_json_file_list_consumer consumer);
+
+	template<json_file_list_consumer Consumer>
+	void load_json_file_list(std::span<char const> data, Consumer& consumer)
+	{
+		load_json_file_list(
+			data,
+			type_erased_json_file_list_consumer{
+				.object = &consumer,
+				.set_jobinfo = [](void* object, nlohmann::json&& jobinfo) {
+					static_cast<Consumer*>(object)->set_jobinfo(std::move(jobinfo));
+				},
+				.append = [](void* object, file_list&& files) {
+					return static_cast<Consumer*>(object)->append(std::move(files));
+				}
+			}
+		);
+	}
+}
+
+#endif
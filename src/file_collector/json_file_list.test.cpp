@@ -0,0 +1,149 @@
+//@	{"target":{"name":"json_file_list.test"}}
+
+#include "./json_file_list.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <array>
+#include <format>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct file_list_collector
+	{
+		void set_jobinfo(nlohmann::json&& obj)
+		{
+			jobinfo = std::move(obj);
+			files_before_jobinfo = std::size(files);
+		}
+
+		bool append(slideproj::file_collector::file_list&& batch)
+		{
+			batch_sizes.push_back(std::size(batch));
+			files.append(std::move(batch));
+			return std::size(batch_sizes) != max_batch_count;
+		}
+
+		nlohmann::json jobinfo;
+		size_t files_before_jobinfo{0};
+		slideproj::file_collector::file_list files;
+		std::vector<size_t> batch_sizes;
+		size_t max_batch_count{0};
+	};
+
+	std::string make_file_list_document(size_t file_count, bool jobinfo_first)
+	{
+		auto const jobinfo = std::format(
+			R"("slideproj_create_jobinfo": {{"order_by": ["timestamp"], "working_directory": "{}"}})",
+			std::filesystem::current_path().native()
+		);
+
+		std::string files{R"("files": [)"};
+		for(size_t k = 0; k != file_count; ++k)
+		{
+			if(k != 0)
+			{ files += ", "; }
+			files += k%2 == 0?
+				R"({"path": "testdata/rgba_8bit_srgb.png", "unused": {"path": 1}})":
+				R"({"path": "testdata/../testdata/rgba_8bit_srgb.bmp"})";
+		}
+		files += "]";
+
+		return jobinfo_first?
+			std::format("{{{}, {}}}", jobinfo, files):
+			std::format("{{{}, {}}}", files, jobinfo);
+	}
+}
+
+TESTCASE(slideproj_file_collector_load_json_file_list_jobinfo_first)
+{
+	auto const document = make_file_list_document(100, true);
+	file_list_collector collector;
+	slideproj::file_collector::load_json_file_list(document, collector);
+
+	EXPECT_EQ(collector.jobinfo.at("order_by").at(0).get<std::string>(), "timestamp");
+	EXPECT_EQ(collector.files_before_jobinfo, 0);
+	REQUIRE_EQ(std::size(collector.files), 100);
+	auto const wd = std::filesystem::current_path();
+	EXPECT_EQ(collector.files[0].path(), wd/"testdata/rgba_8bit_srgb.png");
+	EXPECT_EQ(collector.files[1].path(), wd/"testdata/rgba_8bit_srgb.bmp");
+	EXPECT_EQ(collector.files[99].id(), slideproj::file_collector::file_id{99});
+
+	REQUIRE_EQ(std::size(collector.batch_sizes), 3);
+	EXPECT_EQ(collector.batch_sizes[0], 16);
+	EXPECT_EQ(collector.batch_sizes[1], 32);
+	EXPECT_EQ(collector.batch_sizes[2], 52);
+}
+
+TESTCASE(slideproj_file_collector_load_json_file_list_jobinfo_last)
+{
+	auto const document = make_file_list_document(20, false);
+	file_list_collector collector;
+	slideproj::file_collector::load_json_file_list(document, collector);
+
+	EXPECT_EQ(collector.files_before_jobinfo, 0);
+	REQUIRE_EQ(std::size(collector.files), 20);
+	EXPECT_EQ(collector.files[19].path(), std::filesystem::current_path()/"testdata/rgba_8bit_srgb.bmp");
+}
+
+TESTCASE(slideproj_file_collector_load_json_file_list_stop_early)
+{
+	auto const document = make_file_list_document(100, true);
+	file_list_collector collector;
+	collector.max_batch_count = 1;
+	slideproj::file_collector::load_json_file_list(document, collector);
+
+	EXPECT_EQ(std::size(collector.files), 16);
+	EXPECT_EQ(std::size(collector.batch_sizes), 1);
+}
+
+TESTCASE(slideproj_file_collector_load_json_file_list_skip_invalid_entries)
+{
+	auto const document = std::format(
+		R"({{"slideproj_create_jobinfo": {{"working_directory": "{}"}}, "files": [1, [], {{}}, {{"path": 2}}, {{"path": "testdata/rgba_8bit_srgb.png"}}]}})",
+		std::filesystem::current_path().native()
+	);
+	file_list_collector collector;
+	slideproj::file_collector::load_json_file_list(document, collector);
+
+	REQUIRE_EQ(std::size(collector.files), 1);
+	EXPECT_EQ(collector.files[0].path(), std::filesystem::current_path()/"testdata/rgba_8bit_srgb.png");
+}
+
+TESTCASE(slideproj_file_collector_load_json_file_list_skip_missing_files)
+{
+	auto const document = std::format(
+		R"({{"slideproj_create_jobinfo": {{"working_directory": "{}"}}, "files": [{{"path": "testdata/does_not_exist.png"}}, {{"path": "testdata/rgba_8bit_srgb.png"}}]}})",
+		std::filesystem::current_path().native()
+	);
+	file_list_collector collector;
+	slideproj::file_collector::load_json_file_list(document, collector);
+
+	REQUIRE_EQ(std::size(collector.files), 1);
+	EXPECT_EQ(collector.files[0].path(), std::filesystem::current_path()/"testdata/rgba_8bit_srgb.png");
+}
+
+TESTCASE(slideproj_file_collector_load_json_file_list_invalid_input)
+{
+	std::array<std::string_view, 6> const documents{
+		R"({"files": []})",
+		R"({"slideproj_create_jobinfo": {}, "files": []})",
+		R"({"slideproj_create_jobinfo": {"working_directory": 1}, "files": []})",
+		R"({"slideproj_create_jobinfo": {"working_directory": "/"}})",
+		R"({"slideproj_create_jobinfo": {"working_directory": "/"}, "files": {}})",
+		R"({"slideproj_create_jobinfo": {"working_directory": "/"}, "files": [)"
+	};
+
+	for(auto const document : documents)
+	{
+		file_list_collector collector;
+		auto failed = false;
+		try
+		{ slideproj::file_collector::load_json_file_list(document, collector); }
+		catch(std::runtime_error const&)
+		{ failed = true; }
+		EXPECT_EQ(failed, true);
+	}
+}
@@ -16,6 +16,7 @@
 
 #include <GLFW/glfw3.h>
 
+#include <chrono>
 #include <memory>
 #include <format>
 
@@ -89,6 +90,23 @@ namespace slideproj::glfw_wrapper
 		void poll_events()
 		{ glfwPollEvents(); }
 
+		// Blocks until there is an event to process
+		void wait_events()
+		{ glfwWaitEvents(); }
+
+		// Blocks until there is an event to process, or until timeout has passed
+		void wait_events(std::chrono::duration<double> timeout)
+		{
+			if(timeout.count() > 0.0)
+			{ glfwWaitEventsTimeout(timeout.count()); }
+			else
+			{ glfwPollEvents(); }
+		}
+
+		// Wakes up a thread that is waiting for events. This function may be called from any thread.
+		static void post_empty_event()
+		{ glfwPostEmptyEvent(); }
+
 		void swap_buffers()
 		{ glfwSwapBuffers(m_handle.get()); }
 
@@ -185,6 +203,14 @@ namespace slideproj::glfw_wrapper
 				}
 			);
 
+			glfwSetWindowRefreshCallback(
+				m_handle.get(),
+				[](GLFWwindow* window) {
+					auto [self, eh] = get_event_handler(window);
+					eh->handle_event(*self, windowing_api::window_damaged_event{});
+				}
+			);
+
 			glfwSetKeyCallback(
 				m_handle.get(),
 				[](GLFWwindow* window, int, int scancode, int action, int modifiers) {
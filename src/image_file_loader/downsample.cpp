@@ -0,0 +1,478 @@
+//@	{"target": {"name":"downsample.o"}}
+
+#include "./downsample.hpp"
+
+#include "src/utils/numconv.hpp"
+
+#include <algorithm>
+#include <array>
+#include <immintrin.h>
+#include <Imath/half.h>
+
+namespace
+{
+	using slideproj::image_file_loader::instruction_set;
+
+	// Kernels below process as many samples as fits in whole vectors, and return the number of
+	// samples processed. The caller takes care of the rest.
+
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+	namespace sse4_1
+	{
+		size_t add_u8_normalized(uint8_t const* src, size_t n, float* acc)
+		{
+			auto const scale = _mm_set1_ps(1.0f/255.0f);
+			size_t k = 0;
+			for(; k + 4 <= n; k += 4)
+			{
+				int32_t bytes;
+				memcpy(&bytes, src + k, sizeof(bytes));
+				auto const vals = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+				_mm_storeu_ps(acc + k, _mm_add_ps(_mm_loadu_ps(acc + k), _mm_mul_ps(vals, scale)));
+			}
+			return k;
+		}
+
+		size_t add_u16_normalized(uint16_t const* src, size_t n, float* acc)
+		{
+			auto const scale = _mm_set1_ps(1.0f/65535.0f);
+			size_t k = 0;
+			for(; k + 4 <= n; k += 4)
+			{
+				auto const raw = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + k));
+				auto const vals = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(raw));
+				_mm_storeu_ps(acc + k, _mm_add_ps(_mm_loadu_ps(acc + k), _mm_mul_ps(vals, scale)));
+			}
+			return k;
+		}
+
+		size_t add_f32(float const* src, size_t n, float* acc)
+		{
+			size_t k = 0;
+			for(; k + 4 <= n; k += 4)
+			{ _mm_storeu_ps(acc + k, _mm_add_ps(_mm_loadu_ps(acc + k), _mm_loadu_ps(src + k))); }
+			return k;
+		}
+	}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,f16c")
+	namespace avx2
+	{
+		size_t add_u8_normalized(uint8_t const* src, size_t n, float* acc)
+		{
+			auto const scale = _mm256_set1_ps(1.0f/255.0f);
+			size_t k = 0;
+			for(; k + 8 <= n; k += 8)
+			{
+				auto const raw = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + k));
+				auto const vals = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(raw));
+				_mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k), _mm256_mul_ps(vals, scale)));
+			}
+			return k;
+		}
+
+		size_t add_u8_lut(uint8_t const* src, size_t n, float const* lut, int32_t const* lut_offsets, float* acc)
+		{
+			auto const offsets = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lut_offsets));
+			size_t k = 0;
+			for(; k + 8 <= n; k += 8)
+			{
+				auto const raw = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + k));
+				auto const indices = _mm256_add_epi32(_mm256_cvtepu8_epi32(raw), offsets);
+				auto const vals = _mm256_i32gather_ps(lut, indices, sizeof(float));
+				_mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k), vals));
+			}
+			return k;
+		}
+
+		size_t add_u16_lut(uint16_t const* src, size_t n, float const* lut, int32_t const* alpha_lanes, float* acc)
+		{
+			auto const alpha_mask = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(alpha_lanes)));
+			auto const scale = _mm256_set1_ps(1.0f/65535.0f);
+			size_t k = 0;
+			for(; k + 8 <= n; k += 8)
+			{
+				auto const indices = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + k)));
+				auto const vals = _mm256_blendv_ps(
+					_mm256_i32gather_ps(lut, indices, sizeof(float)),
+					_mm256_mul_ps(_mm256_cvtepi32_ps(indices), scale),
+					alpha_mask
+				);
+				_mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k), vals));
+			}
+			return k;
+		}
+
+		size_t add_u16_normalized(uint16_t const* src, size_t n, float* acc)
+		{
+			auto const scale = _mm256_set1_ps(1.0f/65535.0f);
+			size_t k = 0;
+			for(; k + 8 <= n; k += 8)
+			{
+				auto const raw = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + k));
+				auto const vals = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(raw));
+				_mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k), _mm256_mul_ps(vals, scale)));
+			}
+			return k;
+		}
+
+		size_t add_f16(Imath::half const* src, size_t n, float* acc)
+		{
+			size_t k = 0;
+			for(; k + 8 <= n; k += 8)
+			{
+				auto const vals = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + k)));
+				_mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k), vals));
+			}
+			return k;
+		}
+
+		size_t add_f32(float const* src, size_t n, float* acc)
+		{
+			size_t k = 0;
+			for(; k + 8 <= n; k += 8)
+			{ _mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k), _mm256_loadu_ps(src + k))); }
+			return k;
+		}
+	}
+#pragma GCC pop_options
+
+// NOTE: GCC 12 warns about _mm512_undefined_* used inside the AVX-512 intrinsics (GCC bug 105593)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+	namespace avx512
+	{
+		size_t add_u8_normalized(uint8_t const* src, size_t n, float* acc)
+		{
+			auto const scale = _mm512_set1_ps(1.0f/255.0f);
+			size_t k = 0;
+			for(; k + 16 <= n; k += 16)
+			{
+				auto const raw = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + k));
+				auto const vals = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(raw));
+				_mm512_storeu_ps(acc + k, _mm512_add_ps(_mm512_loadu_ps(acc + k), _mm512_mul_ps(vals, scale)));
+			}
+			return k;
+		}
+
+		size_t add_u8_lut(uint8_t const* src, size_t n, float const* lut, int32_t const* lut_offsets, float* acc)
+		{
+			auto const offsets = _mm512_loadu_si512(lut_offsets);
+			size_t k = 0;
+			for(; k + 16 <= n; k += 16)
+			{
+				auto const raw = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + k));
+				auto const indices = _mm512_add_epi32(_mm512_cvtepu8_epi32(raw), offsets);
+				auto const vals = _mm512_i32gather_ps(indices, lut, sizeof(float));
+				_mm512_storeu_ps(acc + k, _mm512_add_ps(_mm512_loadu_ps(acc + k), vals));
+			}
+			return k;
+		}
+
+		size_t add_u16_lut(uint16_t const* src, size_t n, float const* lut, int32_t const* alpha_lanes, float* acc)
+		{
+			auto const alpha_mask = _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(alpha_lanes), _mm512_setzero_si512());
+			auto const scale = _mm512_set1_ps(1.0f/65535.0f);
+			size_t k = 0;
+			for(; k + 16 <= n; k += 16)
+			{
+				auto const indices = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + k)));
+				auto const vals = _mm512_mask_blend_ps(
+					alpha_mask,
+					_mm512_i32gather_ps(indices, lut, sizeof(float)),
+					_mm512_mul_ps(_mm512_cvtepi32_ps(indices), scale)
+				);
+				_mm512_storeu_ps(acc + k, _mm512_add_ps(_mm512_loadu_ps(acc + k), vals));
+			}
+			return k;
+		}
+
+		size_t add_u16_normalized(uint16_t const* src, size_t n, float* acc)
+		{
+			auto const scale = _mm512_set1_ps(1.0f/65535.0f);
+			size_t k = 0;
+			for(; k + 16 <= n; k += 16)
+			{
+				auto const raw = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + k));
+				auto const vals = _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(raw));
+				_mm512_storeu_ps(acc + k, _mm512_add_ps(_mm512_loadu_ps(acc + k), _mm512_mul_ps(vals, scale)));
+			}
+			return k;
+		}
+
+		size_t add_f16(Imath::half const* src, size_t n, float* acc)
+		{
+			size_t k = 0;
+			for(; k + 16 <= n; k += 16)
+			{
+				auto const vals = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + k)));
+				_mm512_storeu_ps(acc + k, _mm512_add_ps(_mm512_loadu_ps(acc + k), vals));
+			}
+			return k;
+		}
+
+		size_t add_f32(float const* src, size_t n, float* acc)
+		{
+			size_t k = 0;
+			for(; k + 16 <= n; k += 16)
+			{ _mm512_storeu_ps(acc + k, _mm512_add_ps(_mm512_loadu_ps(acc + k), _mm512_loadu_ps(src + k))); }
+			return k;
+		}
+	}
+#pragma GCC pop_options
+#pragma GCC diagnostic pop
+
+	// NOTE: The upper half of the table holds normalized values, and is used for the alpha channel
+	template<class IntensityTransferFunction>
+	auto const& get_u8_lut()
+	{
+		static auto const ret = [](){
+			std::array<float, 512> ret{};
+			for(size_t k = 0; k != 256; ++k)
+			{
+				ret[k] = IntensityTransferFunction::to_linear_float(static_cast<uint8_t>(k));
+				ret[k + 256] = slideproj::utils::to_normalized_float(static_cast<uint8_t>(k));
+			}
+			return ret;
+		}();
+		return ret;
+	}
+
+	template<class IntensityTransferFunction, class T>
+	struct scalar_converter
+	{
+		float operator()(T value) const
+		{ return IntensityTransferFunction::to_linear_float(value); }
+	};
+
+	template<class IntensityTransferFunction>
+	struct scalar_converter<IntensityTransferFunction, uint8_t>
+	{
+		std::array<float, 512> const& lut = get_u8_lut<IntensityTransferFunction>();
+
+		float operator()(uint8_t value) const
+		{ return lut[value]; }
+	};
+
+	template<class IntensityTransferFunction>
+	requires requires(){ IntensityTransferFunction::get_u16_lut(); }
+	struct scalar_converter<IntensityTransferFunction, uint16_t>
+	{
+		std::array<float, 65536> const& lut = IntensityTransferFunction::get_u16_lut();
+
+		float operator()(uint16_t value) const
+		{ return lut[value]; }
+	};
+
+	template<class IntensityTransferFunction, class T>
+	void accumulate_linear_scalar(std::span<T const> src, size_t offset, float* acc, size_t channel_count)
+	{
+		scalar_converter<IntensityTransferFunction, T> const to_linear_float{};
+		auto const n = std::size(src);
+		if(channel_count%2 != 0)
+		{
+			for(auto k = offset; k < n; ++k)
+			{ acc[k] += to_linear_float(src[k]); }
+			return;
+		}
+
+		// NOTE: With an alpha channel, offset is at a pixel boundary (see below)
+		for(auto k = offset; k < n; k += channel_count)
+		{
+			for(size_t c = 0; c != channel_count - 1; ++c)
+			{ acc[k + c] += to_linear_float(src[k + c]); }
+			acc[k + channel_count - 1] += slideproj::utils::to_normalized_float(src[k + channel_count - 1]);
+		}
+	}
+
+	// NOTE: Vectors hold a whole number of pixels when the channel count is even, so the same offsets
+	//       can be used for every vector
+	auto make_u8_lut_offsets(size_t channel_count)
+	{
+		std::array<int32_t, 16> ret{};
+		if(channel_count%2 != 0)
+		{ return ret; }
+
+		for(size_t k = 0; k != std::size(ret); ++k)
+		{ ret[k] = (k%channel_count == channel_count - 1)? 256 : 0; }
+		return ret;
+	}
+
+	// NOTE: Alpha is always stored without a transfer function, so its lanes are not looked up
+	auto make_alpha_lanes(size_t channel_count)
+	{
+		std::array<int32_t, 16> ret{};
+		if(channel_count%2 != 0)
+		{ return ret; }
+
+		for(size_t k = 0; k != std::size(ret); ++k)
+		{ ret[k] = (k%channel_count == channel_count - 1)? -1 : 0; }
+		return ret;
+	}
+
+	template<class IntensityTransferFunction, class T>
+	size_t accumulate_linear_vectorized(
+		std::span<T const> src,
+		float* acc,
+		size_t channel_count,
+		instruction_set iset
+	)
+	{
+		constexpr auto is_linear = std::is_same_v<
+			IntensityTransferFunction,
+			slideproj::pixel_store::linear_intensity_mapping
+		>;
+		auto const n = std::size(src);
+		auto const ptr = std::data(src);
+
+		if constexpr(std::is_same_v<T, uint8_t>)
+		{
+			if constexpr(is_linear)
+			{
+				switch(iset)
+				{
+					case instruction_set::avx512:
+						return avx512::add_u8_normalized(ptr, n, acc);
+					case instruction_set::avx2:
+						return avx2::add_u8_normalized(ptr, n, acc);
+					case instruction_set::sse4_1:
+						return sse4_1::add_u8_normalized(ptr, n, acc);
+					case instruction_set::generic:
+						return 0;
+				}
+			}
+			else
+			{
+				// NOTE: There is no gather instruction before AVX2
+				auto const& lut = get_u8_lut<IntensityTransferFunction>();
+				auto const offsets = make_u8_lut_offsets(channel_count);
+				switch(iset)
+				{
+					case instruction_set::avx512:
+						return avx512::add_u8_lut(ptr, n, std::data(lut), std::data(offsets), acc);
+					case instruction_set::avx2:
+						return avx2::add_u8_lut(ptr, n, std::data(lut), std::data(offsets), acc);
+					case instruction_set::sse4_1:
+					case instruction_set::generic:
+						return 0;
+				}
+			}
+		}
+		else
+		if constexpr(std::is_same_v<T, uint16_t> && is_linear)
+		{
+			switch(iset)
+			{
+				case instruction_set::avx512:
+					return avx512::add_u16_normalized(ptr, n, acc);
+				case instruction_set::avx2:
+					return avx2::add_u16_normalized(ptr, n, acc);
+				case instruction_set::sse4_1:
+					return sse4_1::add_u16_normalized(ptr, n, acc);
+				case instruction_set::generic:
+					return 0;
+			}
+		}
+		else
+		if constexpr(std::is_same_v<T, uint16_t>)
+		{
+			auto const& lut = IntensityTransferFunction::get_u16_lut();
+			auto const alpha_lanes = make_alpha_lanes(channel_count);
+			switch(iset)
+			{
+				case instruction_set::avx512:
+					return avx512::add_u16_lut(ptr, n, std::data(lut), std::data(alpha_lanes), acc);
+				case instruction_set::avx2:
+					return avx2::add_u16_lut(ptr, n, std::data(lut), std::data(alpha_lanes), acc);
+				case instruction_set::sse4_1:
+				case instruction_set::generic:
+					return 0;
+			}
+		}
+		else
+		if constexpr(std::is_same_v<T, Imath::half> && is_linear)
+		{
+			// NOTE: Converting from half requires F16C, which is assumed to be present with AVX2
+			switch(iset)
+			{
+				case instruction_set::avx512:
+					return avx512::add_f16(ptr, n, acc);
+				case instruction_set::avx2:
+					return avx2::add_f16(ptr, n, acc);
+				case instruction_set::sse4_1:
+				case instruction_set::generic:
+					return 0;
+			}
+		}
+		else
+		if constexpr(std::is_same_v<T, float> && is_linear)
+		{
+			switch(iset)
+			{
+				case instruction_set::avx512:
+					return avx512::add_f32(ptr, n, acc);
+				case instruction_set::avx2:
+					return avx2::add_f32(ptr, n, acc);
+				case instruction_set::sse4_1:
+					return sse4_1::add_f32(ptr, n, acc);
+				case instruction_set::generic:
+					return 0;
+			}
+		}
+
+		// NOTE: Floating point samples with a non-linear transfer function are left to the scalar code path
+		return 0;
+	}
+
+	instruction_set detect_instruction_set()
+	{
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx512f"))
+		{ return instruction_set::avx512; }
+
+		if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+		{ return instruction_set::avx2; }
+
+		if(__builtin_cpu_supports("sse4.1"))
+		{ return instruction_set::sse4_1; }
+
+		return instruction_set::generic;
+	}
+}
+
+slideproj::image_file_loader::instruction_set slideproj::image_file_loader::get_supported_instruction_set()
+{
+	static auto const ret = detect_instruction_set();
+	return ret;
+}
+
+template<class IntensityTransferFunction, class T>
+void slideproj::image_file_loader::accumulate_linear(
+	std::span<T const> src,
+	float* acc,
+	size_t channel_count,
+	instruction_set iset
+)
+{
+	auto const k = accumulate_linear_vectorized<IntensityTransferFunction>(src, acc, channel_count, iset);
+	accumulate_linear_scalar<IntensityTransferFunction>(src, k, acc, channel_count);
+}
+
+#define SLIDEPROJ_INSTANTIATE_ACCUMULATE_LINEAR(intensity_transfer_function) \
+	template void slideproj::image_file_loader::accumulate_linear<intensity_transfer_function, uint8_t>( \
+		std::span<uint8_t const>, float*, size_t, instruction_set); \
+	template void slideproj::image_file_loader::accumulate_linear<intensity_transfer_function, uint16_t>( \
+		std::span<uint16_t const>, float*, size_t, instruction_set); \
+	template void slideproj::image_file_loader::accumulate_linear<intensity_transfer_function, Imath::half>( \
+		std::span<Imath::half const>, float*, size_t, instruction_set); \
+	template void slideproj::image_file_loader::accumulate_linear<intensity_transfer_function, float>( \
+		std::span<float const>, float*, size_t, instruction_set);
+
+SLIDEPROJ_INSTANTIATE_ACCUMULATE_LINEAR(slideproj::pixel_store::linear_intensity_mapping)
+SLIDEPROJ_INSTANTIATE_ACCUMULATE_LINEAR(slideproj::pixel_store::srgb_intensity_mapping)
+SLIDEPROJ_INSTANTIATE_ACCUMULATE_LINEAR(slideproj::pixel_store::g22_intensity_mapping)
@@ -0,0 +1,532 @@
+//@	{"dependencies_extra":[{"ref":"./downsample.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_IMAGE_FILE_LOADER_DOWNSAMPLE_HPP
+#define SLIDEPROJ_IMAGE_FILE_LOADER_DOWNSAMPLE_HPP
+
+#include "src/pixel_store/basic_image.hpp"
+#include "src/pixel_store/packed_rgba_image.hpp"
+#include "src/pixel_store/pixel_types.hpp"
+#include "src/pixel_store/rgba_image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace slideproj::image_file_loader
+{
+	enum class instruction_set{generic, sse4_1, avx2, avx512};
+
+	// NOTE: The result is detected on first call, and then cached
+	instruction_set get_supported_instruction_set();
+
+	// Adds the samples in src, converted to linear float, to acc. If channel_count is even, the last
+	// channel is alpha, which is only normalized.
+	//
+	// NOTE: Instantiated for uint8_t, uint16_t, Imath::half, and float, using any of the intensity
+	//       mappings in pixel_store
+	template<class IntensityTransferFunction, class T>
+	void accumulate_linear(
+		std::span<T const> src,
+		float* acc,
+		size_t channel_count,
+		instruction_set iset
+	);
+
+	template<size_t ChannelCount>
+	constexpr auto make_float_pixel(std::array<float, ChannelCount> const& values)
+	{
+		if constexpr(ChannelCount == 1)
+		{ return pixel_store::pixel_type<float, 1>{.gray = values[0]}; }
+		else
+		if constexpr(ChannelCount == 2)
+		{ return pixel_store::pixel_type<float, 2>{.gray = values[0], .alpha = values[1]}; }
+		else
+		if constexpr(ChannelCount == 3)
+		{ return pixel_store::pixel_type<float, 3>{.red = values[0], .green = values[1], .blue = values[2]}; }
+		else
+		{
+			return pixel_store::pixel_type<float, 4>{
+				.red = values[0],
+				.green = values[1],
+				.blue = values[2],
+				.alpha = values[3]
+			};
+		}
+	}
+
+	// Downsamples one row at a time. Instead of visiting each output pixel, scaling_factor input rows
+	// are added into a strip of floats using accumulate_linear, which is then reduced horizontally.
+	//
+	// NOTE: The row buffers are owned by the object, so each thread needs its own row_downsampler
+	template<class PixelType>
+	class row_downsampler
+	{
+	public:
+		using sample_type = typename PixelType::sample_type;
+		using value_type = typename sample_type::value_type;
+		using intensity_transfer_function = typename sample_type::intensity_transfer_function;
+		using output_pixel_type = pixel_store::pixel_type<float, PixelType::channel_count>;
+		static constexpr auto channel_count = static_cast<size_t>(PixelType::channel_count);
+		static_assert(sizeof(PixelType) == channel_count*sizeof(value_type));
+
+		explicit row_downsampler(uint32_t w, uint32_t scaling_factor, instruction_set iset):
+			m_w_out{w/scaling_factor},
+			m_scaling_factor{scaling_factor},
+			m_iset{iset},
+			m_samples_per_row_in{static_cast<size_t>(w)*channel_count},
+			m_samples_per_block{static_cast<size_t>(scaling_factor)*channel_count},
+			// NOTE: Rows are processed in strips, so the accumulator stays in L1 cache
+			m_blocks_per_strip{
+				std::clamp(
+					strip_size/m_samples_per_block,
+					static_cast<size_t>(1),
+					static_cast<size_t>(m_w_out)
+				)
+			},
+			m_acc{std::make_unique_for_overwrite<float[]>(m_blocks_per_strip*m_samples_per_block)},
+			m_row_out{std::make_unique_for_overwrite<output_pixel_type[]>(m_w_out)}
+		{}
+
+		// Returns the output row made from the scaling_factor consecutive input rows starting at rows.
+		// The result is valid until the next call.
+		std::span<output_pixel_type const> operator()(PixelType const* rows)
+		{
+			auto const samples_in = reinterpret_cast<value_type const*>(rows);
+			auto const block_size = static_cast<float>(m_scaling_factor)*static_cast<float>(m_scaling_factor);
+			for(size_t x_begin = 0; x_begin < m_w_out; x_begin += m_blocks_per_strip)
+			{
+				auto const block_count = std::min(m_blocks_per_strip, m_w_out - x_begin);
+				auto const samples_per_strip = block_count*m_samples_per_block;
+				std::fill_n(m_acc.get(), samples_per_strip, 0.0f);
+				for(uint32_t eta = 0; eta != m_scaling_factor; ++eta)
+				{
+					accumulate_linear<intensity_transfer_function>(
+						std::span{samples_in + eta*m_samples_per_row_in + x_begin*m_samples_per_block, samples_per_strip},
+						m_acc.get(),
+						channel_count,
+						m_iset
+					);
+				}
+
+				for(size_t x = 0; x != block_count; ++x)
+				{
+					auto const block = m_acc.get() + x*m_samples_per_block;
+					std::array<float, channel_count> sum{};
+					for(size_t xi = 0; xi != m_scaling_factor; ++xi)
+					{
+						for(size_t c = 0; c != channel_count; ++c)
+						{ sum[c] += block[xi*channel_count + c]; }
+					}
+
+					for(size_t c = 0; c != channel_count; ++c)
+					{ sum[c] /= block_size; }
+					m_row_out[x_begin + x] = make_float_pixel(sum);
+				}
+			}
+
+			return std::span<output_pixel_type const>{m_row_out.get(), m_w_out};
+		}
+
+	private:
+		static constexpr size_t strip_size = 4096;
+
+		size_t m_w_out;
+		uint32_t m_scaling_factor;
+		instruction_set m_iset;
+		size_t m_samples_per_row_in;
+		size_t m_samples_per_block;
+		size_t m_blocks_per_strip;
+		std::unique_ptr<float[]> m_acc;
+		std::unique_ptr<output_pixel_type[]> m_row_out;
+	};
+
+	template<class RowSource>
+	using row_source_pixel_type = std::remove_cvref_t<
+		std::remove_pointer_t<std::invoke_result_t<RowSource&, uint32_t>>
+	>;
+
+	// Calls row_callback(y, row) for every row of the downsampled image, in order, using a
+	// row_downsampler.
+	//
+	// get_rows(y) must return a pointer to the scaling_factor consecutive input rows that make up
+	// output row y. Rows are requested in order, which makes it possible to decode the input in
+	// bands.
+	//
+	// NOTE: The caller must make sure that the output is not empty
+	template<class RowSource, class RowCallback>
+	requires std::invocable<RowSource&, uint32_t>
+	void for_each_downsampled_row(
+		RowSource&& get_rows,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		instruction_set iset,
+		RowCallback&& row_callback
+	)
+	{
+		row_downsampler<row_source_pixel_type<RowSource>> downsample{w, scaling_factor, iset};
+		auto const h_out = h/scaling_factor;
+		for(uint32_t y = 0; y != h_out; ++y)
+		{ row_callback(y, downsample(get_rows(y))); }
+	}
+
+	template<class PixelType, class RowCallback>
+	void for_each_downsampled_row(
+		PixelType const* pixels,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		instruction_set iset,
+		RowCallback&& row_callback
+	)
+	{
+		for_each_downsampled_row(
+			[pixels, rows_per_output_row = static_cast<size_t>(w)*scaling_factor](uint32_t y) {
+				return pixels + y*rows_per_output_row;
+			},
+			w, h, scaling_factor, iset,
+			std::forward<RowCallback>(row_callback)
+		);
+	}
+
+	template<class PixelType>
+	constexpr auto to_rgba(PixelType const& item, bool premultiply)
+	{
+		auto ret = item.to_rgba();
+		if(premultiply)
+		{
+			ret.red *= ret.alpha;
+			ret.green *= ret.alpha;
+			ret.blue *= ret.alpha;
+		}
+		return ret;
+	}
+
+	// Same as for_each_downsampled_row, but rows are expanded to RGBA, and optionally premultiplied
+	template<class RowSource, class RowCallback>
+	void for_each_downsampled_rgba_row(
+		RowSource&& get_rows,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		bool premultiply,
+		instruction_set iset,
+		RowCallback&& row_callback
+	)
+	{
+		auto const row_out = std::make_unique_for_overwrite<pixel_store::rgba_pixel[]>(w/scaling_factor);
+		for_each_downsampled_row(
+			std::forward<RowSource>(get_rows), w, h, scaling_factor, iset,
+			[&row_out, &row_callback, premultiply](uint32_t y, auto row) {
+				std::ranges::transform(row, row_out.get(), [premultiply](auto const& item) {
+					return to_rgba(item, premultiply);
+				});
+				row_callback(y, std::span<pixel_store::rgba_pixel const>{row_out.get(), std::size(row)});
+			}
+		);
+	}
+
+	// Same result as the downsample_to_linear in image_file_loader.hpp, up to rounding errors
+	template<class PixelType>
+	auto downsample_to_linear(
+		PixelType const* pixels,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		instruction_set iset
+	)
+	{
+		using pixel_type_ret = pixel_store::pixel_type<float, PixelType::channel_count>;
+		auto const w_out = w/scaling_factor;
+		auto const h_out = h/scaling_factor;
+		if(w_out == 0 || h_out == 0)
+		{ return pixel_store::basic_image<pixel_type_ret>{}; }
+
+		pixel_store::basic_image<pixel_type_ret> ret{w_out, h_out, pixel_store::make_uninitialized_pixel_buffer_tag{}};
+		for_each_downsampled_row(
+			pixels, w, h, scaling_factor, iset,
+			[pixels_out = ret.pixels(), w_out](uint32_t y, std::span<pixel_type_ret const> row) {
+				std::ranges::copy(row, pixels_out + static_cast<size_t>(y)*w_out);
+			}
+		);
+		return ret;
+	}
+
+	// Describes where pixel (x, y) of the downsampled image ends up in the output image, which is at
+	// origin + x*x_step + y*y_step
+	struct output_layout
+	{
+		pixel_store::image_rectangle size;
+		ptrdiff_t origin;
+		ptrdiff_t x_step;
+		ptrdiff_t y_step;
+	};
+
+	// Copies row_count rows of row_length pixels, that start at row y_begin of the downsampled image, to
+	// their position in pixels_out
+	//
+	// NOTE: For transposed images, rows are copied column by column, so each output row receives a
+	//       contiguous run of pixels
+	template<class PixelType>
+	void write_oriented_rows(
+		PixelType* pixels_out,
+		output_layout const& layout,
+		uint32_t y_begin,
+		uint32_t row_count,
+		uint32_t row_length,
+		PixelType const* rows
+	)
+	{
+		auto const origin = pixels_out + layout.origin + static_cast<ptrdiff_t>(y_begin)*layout.y_step;
+		if(layout.x_step == 1 || layout.x_step == -1)
+		{
+			for(uint32_t k = 0; k != row_count; ++k)
+			{
+				auto const row_in = rows + static_cast<size_t>(k)*row_length;
+				auto const row_out = origin + static_cast<ptrdiff_t>(k)*layout.y_step;
+				for(size_t x = 0; x != row_length; ++x)
+				{ row_out[static_cast<ptrdiff_t>(x)*layout.x_step] = row_in[x]; }
+			}
+			return;
+		}
+
+		for(size_t x = 0; x != row_length; ++x)
+		{
+			auto const dest = origin + static_cast<ptrdiff_t>(x)*layout.x_step;
+			for(uint32_t k = 0; k != row_count; ++k)
+			{ dest[static_cast<ptrdiff_t>(k)*layout.y_step] = rows[k*static_cast<size_t>(row_length) + x]; }
+		}
+	}
+
+	// Writes rows to their position in the output image, as given by an output_layout, converting
+	// them to PixelType. Rows must be written in order.
+	template<class PixelType>
+	class oriented_image_writer
+	{
+	public:
+		explicit oriented_image_writer(output_layout const& layout, uint32_t row_length):
+			m_layout{layout},
+			m_row_length{row_length},
+			m_output{layout.size.width, layout.size.height, pixel_store::make_uninitialized_pixel_buffer_tag{}},
+			m_band{
+				layout.x_step == 1 || layout.x_step == -1?
+					pixel_store::pooled_pixel_buffer<PixelType>{}:
+					pixel_store::make_pooled_pixel_buffer<PixelType>(static_cast<size_t>(band_size)*row_length)
+			},
+			m_band_begin{0},
+			m_band_row_count{0}
+		{}
+
+		void write_row(uint32_t y, std::span<pixel_store::rgba_pixel const> row)
+		{
+			if(m_band == nullptr)
+			{
+				auto const row_out = m_output.pixels() + m_layout.origin + static_cast<ptrdiff_t>(y)*m_layout.y_step;
+				for(size_t x = 0; x != std::size(row); ++x)
+				{
+					row_out[static_cast<ptrdiff_t>(x)*m_layout.x_step] =
+						pixel_store::make_pixel_from_linear<PixelType>(row[x]);
+				}
+				return;
+			}
+
+			std::ranges::transform(
+				row,
+				m_band.get() + static_cast<size_t>(m_band_row_count)*m_row_length,
+				pixel_store::make_pixel_from_linear<PixelType>
+			);
+			++m_band_row_count;
+			if(m_band_row_count == band_size)
+			{ flush_band(); }
+		}
+
+		pixel_store::basic_image<PixelType> finish() &&
+		{
+			if(m_band != nullptr)
+			{ flush_band(); }
+			return std::move(m_output);
+		}
+
+	private:
+		// NOTE: For transposed images, this many rows are collected before they are written, so
+		//       each output row receives a contiguous run of pixels
+		static constexpr uint32_t band_size = 8;
+
+		void flush_band()
+		{
+			write_oriented_rows(m_output.pixels(), m_layout, m_band_begin, m_band_row_count, m_row_length, m_band.get());
+			m_band_begin += m_band_row_count;
+			m_band_row_count = 0;
+		}
+
+		output_layout m_layout;
+		uint32_t m_row_length;
+		pixel_store::basic_image<PixelType> m_output;
+		// NOTE: Only used when the image is transposed
+		pixel_store::pooled_pixel_buffer<PixelType> m_band;
+		uint32_t m_band_begin;
+		uint32_t m_band_row_count;
+	};
+
+	// Downsamples, reorients, expands to RGBA, and premultiplies in one pass. Only the output image is
+	// allocated, apart from small row buffers.
+	template<class OutputPixelType = pixel_store::rgba_pixel, class RowSource>
+	pixel_store::basic_image<OutputPixelType> downsample_to_linear_rgba(
+		RowSource&& get_rows,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		output_layout const& layout,
+		bool premultiply,
+		instruction_set iset
+	)
+	{
+		if(w/scaling_factor == 0 || h/scaling_factor == 0)
+		{ return pixel_store::basic_image<OutputPixelType>{}; }
+
+		oriented_image_writer<OutputPixelType> writer{layout, w/scaling_factor};
+		for_each_downsampled_rgba_row(
+			std::forward<RowSource>(get_rows), w, h, scaling_factor, premultiply, iset,
+			[&writer](uint32_t y, std::span<pixel_store::rgba_pixel const> row) {
+				writer.write_row(y, row);
+			}
+		);
+		return std::move(writer).finish();
+	}
+
+	// Parallel version of for_each_downsampled_rgba_row. get_rows is called in order, from the calling
+	// thread, for rows_per_batch output rows at a time. The rows of a batch, which starts at a multiple
+	// of rows_per_batch, must stay valid at the same time.
+	//
+	// Each batch is split into items of a few rows, which are handed to parallel_for(item_count, func).
+	// parallel_for must call func(k) for every k in [0, item_count) before it returns. func(k)
+	// downsamples the rows of item k, and passes them to rows_callback(y_begin, row_count, rows),
+	// where rows holds row_count consecutive rows. When a batch is done, batch_callback(y_begin,
+	// row_count) is called from the calling thread.
+	//
+	// NOTE: The caller must make sure that the output is not empty
+	template<class RowSource, class ParallelFor, class RowsCallback, class BatchCallback>
+	requires std::invocable<RowSource&, uint32_t>
+	void for_each_downsampled_rgba_batch(
+		RowSource&& get_rows,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		bool premultiply,
+		instruction_set iset,
+		uint32_t rows_per_batch,
+		ParallelFor&& parallel_for,
+		RowsCallback&& rows_callback,
+		BatchCallback&& batch_callback
+	)
+	{
+		using PixelType = row_source_pixel_type<RowSource>;
+		constexpr uint32_t rows_per_item = 8;
+		auto const w_out = w/scaling_factor;
+		auto const h_out = h/scaling_factor;
+		std::vector<PixelType const*> input_rows(std::min(rows_per_batch, h_out));
+		for(uint32_t batch_begin = 0; batch_begin < h_out; batch_begin += rows_per_batch)
+		{
+			auto const row_count = std::min(rows_per_batch, h_out - batch_begin);
+			for(uint32_t k = 0; k != row_count; ++k)
+			{ input_rows[k] = get_rows(batch_begin + k); }
+
+			parallel_for(
+				(row_count + rows_per_item - 1)/rows_per_item,
+				[&input_rows, &rows_callback, batch_begin, row_count, w, w_out, scaling_factor, premultiply, iset](
+					size_t item
+				) {
+					auto const begin = static_cast<uint32_t>(item)*rows_per_item;
+					auto const end = std::min(begin + rows_per_item, row_count);
+					row_downsampler<PixelType> downsample{w, scaling_factor, iset};
+					auto const rows = pixel_store::make_pooled_pixel_buffer<pixel_store::rgba_pixel>(
+						static_cast<size_t>(end - begin)*w_out
+					);
+					for(auto k = begin; k != end; ++k)
+					{
+						std::ranges::transform(
+							downsample(input_rows[k]),
+							rows.get() + static_cast<size_t>(k - begin)*w_out,
+							[premultiply](auto const& pixel) { return to_rgba(pixel, premultiply); }
+						);
+					}
+					rows_callback(batch_begin + begin, end - begin, static_cast<pixel_store::rgba_pixel const*>(rows.get()));
+				}
+			);
+			batch_callback(batch_begin, row_count);
+		}
+	}
+
+	// Same as downsample_to_linear_rgba above, but rows are processed in parallel, as described by
+	// for_each_downsampled_rgba_batch
+	template<class OutputPixelType, class RowSource, class ParallelFor>
+	pixel_store::basic_image<OutputPixelType> downsample_to_linear_rgba(
+		RowSource&& get_rows,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		output_layout const& layout,
+		bool premultiply,
+		instruction_set iset,
+		uint32_t rows_per_batch,
+		ParallelFor&& parallel_for
+	)
+	{
+		if(w/scaling_factor == 0 || h/scaling_factor == 0)
+		{ return pixel_store::basic_image<OutputPixelType>{}; }
+
+		pixel_store::basic_image<OutputPixelType> ret{
+			layout.size.width,
+			layout.size.height,
+			pixel_store::make_uninitialized_pixel_buffer_tag{}
+		};
+		for_each_downsampled_rgba_batch(
+			std::forward<RowSource>(get_rows), w, h, scaling_factor, premultiply, iset,
+			rows_per_batch,
+			std::forward<ParallelFor>(parallel_for),
+			[&layout, pixels_out = ret.pixels(), w_out = w/scaling_factor](
+				uint32_t y_begin,
+				uint32_t row_count,
+				pixel_store::rgba_pixel const* rows
+			) {
+				auto const converted = pixel_store::make_pooled_pixel_buffer<OutputPixelType>(static_cast<size_t>(row_count)*w_out);
+				std::transform(
+					rows,
+					rows + static_cast<size_t>(row_count)*w_out,
+					converted.get(),
+					pixel_store::make_pixel_from_linear<OutputPixelType>
+				);
+				write_oriented_rows(pixels_out, layout, y_begin, row_count, w_out, static_cast<OutputPixelType const*>(converted.get()));
+			},
+			[](uint32_t, uint32_t){}
+		);
+		return ret;
+	}
+
+	template<class OutputPixelType = pixel_store::rgba_pixel, class PixelType>
+	pixel_store::basic_image<OutputPixelType> downsample_to_linear_rgba(
+		PixelType const* pixels,
+		uint32_t w,
+		uint32_t h,
+		uint32_t scaling_factor,
+		output_layout const& layout,
+		bool premultiply,
+		instruction_set iset
+	)
+	{
+		return downsample_to_linear_rgba<OutputPixelType>(
+			[pixels, rows_per_output_row = static_cast<size_t>(w)*scaling_factor](uint32_t y) {
+				return pixels + y*rows_per_output_row;
+			},
+			w, h, scaling_factor, layout, premultiply, iset
+		);
+	}
+}
+
+#endif
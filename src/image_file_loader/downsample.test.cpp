@@ -0,0 +1,315 @@
+//@	{"target":{"name":"downsample.test"}}
+
+#include "./downsample.hpp"
+#include "./image_file_loader.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace
+{
+	template<class PixelType>
+	auto make_random_pixels(uint32_t w, uint32_t h)
+	{
+		using value_type = typename PixelType::sample_type::value_type;
+		auto const sample_count = static_cast<size_t>(w)*h*PixelType::channel_count;
+		auto ret = std::make_unique_for_overwrite<PixelType[]>(static_cast<size_t>(w)*h);
+		auto const samples = reinterpret_cast<value_type*>(ret.get());
+		std::mt19937 rng{static_cast<uint32_t>(sample_count)};
+		for(size_t k = 0; k != sample_count; ++k)
+		{
+			if constexpr(std::is_integral_v<value_type>)
+			{ samples[k] = static_cast<value_type>(rng()); }
+			else
+			{ samples[k] = static_cast<value_type>(std::uniform_real_distribution{0.0f, 1.0f}(rng)); }
+		}
+		return ret;
+	}
+
+	template<class PixelType>
+	void compare_with_reference(uint32_t w, uint32_t h, uint32_t scaling_factor)
+	{
+		auto const pixels = make_random_pixels<PixelType>(w, h);
+		auto const expected = slideproj::image_file_loader::downsample_to_linear(pixels.get(), w, h, scaling_factor);
+		auto const supported = slideproj::image_file_loader::get_supported_instruction_set();
+		std::array const isets{
+			slideproj::image_file_loader::instruction_set::generic,
+			slideproj::image_file_loader::instruction_set::sse4_1,
+			slideproj::image_file_loader::instruction_set::avx2,
+			slideproj::image_file_loader::instruction_set::avx512
+		};
+
+		for(auto const iset : isets)
+		{
+			if(iset > supported)
+			{ break; }
+
+			auto const res = slideproj::image_file_loader::downsample_to_linear(
+				pixels.get(), w, h, scaling_factor, iset
+			);
+			REQUIRE_EQ(res.width(), expected.width());
+			REQUIRE_EQ(res.height(), expected.height());
+
+			auto const sample_count = expected.pixel_count()*PixelType::channel_count;
+			std::vector<float> samples_expected(sample_count);
+			std::vector<float> samples_res(sample_count);
+			memcpy(std::data(samples_expected), expected.pixels(), sample_count*sizeof(float));
+			memcpy(std::data(samples_res), res.pixels(), sample_count*sizeof(float));
+
+			auto max_error = 0.0f;
+			for(size_t k = 0; k != sample_count; ++k)
+			{ max_error = std::max(max_error, std::abs(samples_res[k] - samples_expected[k])); }
+			EXPECT_LT(max_error, 1.0e-6f);
+		}
+	}
+
+	template<class T, class IntensityTransferFunction, size_t ChannelCount>
+	using test_pixel = slideproj::pixel_store::pixel_type<
+		slideproj::image_file_loader::sample_type<T, IntensityTransferFunction>,
+		ChannelCount
+	>;
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_uint8_srgb)
+{
+	using slideproj::pixel_store::srgb_intensity_mapping;
+	compare_with_reference<test_pixel<uint8_t, srgb_intensity_mapping, 3>>(37, 29, 3);
+	compare_with_reference<test_pixel<uint8_t, srgb_intensity_mapping, 4>>(37, 29, 3);
+	compare_with_reference<test_pixel<uint8_t, srgb_intensity_mapping, 4>>(64, 64, 4);
+	compare_with_reference<test_pixel<uint8_t, srgb_intensity_mapping, 2>>(41, 17, 2);
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_uint8_other)
+{
+	using slideproj::pixel_store::linear_intensity_mapping;
+	using slideproj::pixel_store::g22_intensity_mapping;
+	compare_with_reference<test_pixel<uint8_t, linear_intensity_mapping, 4>>(37, 29, 3);
+	compare_with_reference<test_pixel<uint8_t, g22_intensity_mapping, 1>>(37, 29, 5);
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_uint16)
+{
+	using slideproj::pixel_store::linear_intensity_mapping;
+	using slideproj::pixel_store::srgb_intensity_mapping;
+	using slideproj::pixel_store::g22_intensity_mapping;
+	compare_with_reference<test_pixel<uint16_t, linear_intensity_mapping, 4>>(37, 29, 3);
+	compare_with_reference<test_pixel<uint16_t, linear_intensity_mapping, 3>>(37, 29, 2);
+	compare_with_reference<test_pixel<uint16_t, srgb_intensity_mapping, 3>>(37, 29, 2);
+	compare_with_reference<test_pixel<uint16_t, srgb_intensity_mapping, 4>>(37, 29, 3);
+	compare_with_reference<test_pixel<uint16_t, srgb_intensity_mapping, 2>>(41, 17, 2);
+	compare_with_reference<test_pixel<uint16_t, g22_intensity_mapping, 1>>(37, 29, 5);
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_float)
+{
+	using slideproj::pixel_store::linear_intensity_mapping;
+	compare_with_reference<test_pixel<Imath::half, linear_intensity_mapping, 4>>(37, 29, 3);
+	compare_with_reference<test_pixel<Imath::half, linear_intensity_mapping, 3>>(37, 29, 2);
+	compare_with_reference<test_pixel<float, linear_intensity_mapping, 4>>(37, 29, 3);
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_too_small)
+{
+	using slideproj::pixel_store::srgb_intensity_mapping;
+	auto const pixels = make_random_pixels<test_pixel<uint8_t, srgb_intensity_mapping, 4>>(3, 3);
+	auto const res = slideproj::image_file_loader::downsample_to_linear(
+		pixels.get(), 3, 3, 4, slideproj::image_file_loader::get_supported_instruction_set()
+	);
+	EXPECT_EQ(res.is_empty(), true);
+}
+
+namespace
+{
+	template<class PixelType>
+	auto make_reference_rgba(
+		slideproj::pixel_store::basic_image<PixelType> const& src,
+		slideproj::image_file_loader::pixel_ordering value,
+		bool premultiply
+	)
+	{
+		using slideproj::image_file_loader::apply_pixel_ordering;
+		using enum slideproj::image_file_loader::pixel_ordering;
+		auto const finish = [premultiply](auto const& oriented) {
+			auto ret = slideproj::image_file_loader::to_rgba(oriented.pixels(), oriented.width(), oriented.height());
+			if(premultiply)
+			{
+				auto const pixels = ret.pixels();
+				for(size_t k = 0; k != ret.pixel_count(); ++k)
+				{
+					pixels[k].red *= pixels[k].alpha;
+					pixels[k].green *= pixels[k].alpha;
+					pixels[k].blue *= pixels[k].alpha;
+				}
+			}
+			return ret;
+		};
+
+		switch(value)
+		{
+			case top_to_bottom_right_to_left:
+				return finish(apply_pixel_ordering<top_to_bottom_right_to_left>(src));
+			case bottom_to_top_right_to_left:
+				return finish(apply_pixel_ordering<bottom_to_top_right_to_left>(src));
+			case bottom_to_top_left_to_right:
+				return finish(apply_pixel_ordering<bottom_to_top_left_to_right>(src));
+			case left_to_right_top_to_bottom:
+				return finish(apply_pixel_ordering<left_to_right_top_to_bottom>(src));
+			case right_to_left_top_to_bottom:
+				return finish(apply_pixel_ordering<right_to_left_top_to_bottom>(src));
+			case right_to_left_bottom_to_top:
+				return finish(apply_pixel_ordering<right_to_left_bottom_to_top>(src));
+			case left_to_right_bottom_to_top:
+				return finish(apply_pixel_ordering<left_to_right_bottom_to_top>(src));
+			default:
+				return finish(src);
+		}
+	}
+
+	template<class PixelType>
+	void compare_fused_with_reference(uint32_t w, uint32_t h, uint32_t scaling_factor)
+	{
+		auto const pixels = make_random_pixels<PixelType>(w, h);
+		auto const downsampled = slideproj::image_file_loader::downsample_to_linear(pixels.get(), w, h, scaling_factor);
+		auto const iset = slideproj::image_file_loader::get_supported_instruction_set();
+		for(int k = 0; k != 8; ++k)
+		{
+			auto const pixel_ordering = static_cast<slideproj::image_file_loader::pixel_ordering>(k);
+			for(auto const premultiply : {false, true})
+			{
+				auto const expected = make_reference_rgba(downsampled, pixel_ordering, premultiply);
+				auto const res = slideproj::image_file_loader::downsample_to_linear_rgba(
+					pixels.get(), w, h, scaling_factor,
+					slideproj::image_file_loader::make_output_layout(pixel_ordering, w/scaling_factor, h/scaling_factor),
+					premultiply,
+					iset
+				);
+				REQUIRE_EQ(res.width(), expected.width());
+				REQUIRE_EQ(res.height(), expected.height());
+
+				auto max_error = 0.0f;
+				for(size_t i = 0; i != expected.pixel_count(); ++i)
+				{
+					auto const a = res.pixels()[i];
+					auto const b = expected.pixels()[i];
+					max_error = std::max({
+						max_error,
+						std::abs(a.red - b.red),
+						std::abs(a.green - b.green),
+						std::abs(a.blue - b.blue),
+						std::abs(a.alpha - b.alpha)
+					});
+				}
+				EXPECT_LT(max_error, 1.0e-6f);
+			}
+		}
+	}
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_to_linear_rgba)
+{
+	using slideproj::pixel_store::srgb_intensity_mapping;
+	using slideproj::pixel_store::linear_intensity_mapping;
+	compare_fused_with_reference<test_pixel<uint8_t, srgb_intensity_mapping, 4>>(37, 29, 3);
+	compare_fused_with_reference<test_pixel<uint8_t, srgb_intensity_mapping, 3>>(61, 83, 2);
+	compare_fused_with_reference<test_pixel<uint8_t, srgb_intensity_mapping, 2>>(41, 17, 1);
+	compare_fused_with_reference<test_pixel<Imath::half, linear_intensity_mapping, 1>>(37, 29, 3);
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_to_linear_rgba_packed)
+{
+	using slideproj::pixel_store::srgb_intensity_mapping;
+	using slideproj::pixel_store::rgba8_srgb_pixel;
+	using slideproj::pixel_store::rgba16f_pixel;
+	using slideproj::pixel_store::make_pixel_from_linear;
+
+	EXPECT_EQ(slideproj::pixel_store::to_srgb8(0.0f), 0);
+	EXPECT_EQ(slideproj::pixel_store::to_srgb8(0.5f), 188);
+	EXPECT_EQ(slideproj::pixel_store::to_srgb8(1.0f), 255);
+	EXPECT_EQ(slideproj::pixel_store::to_srgb8(2.0f), 255);
+
+	constexpr uint32_t w = 37;
+	constexpr uint32_t h = 29;
+	constexpr uint32_t scaling_factor = 3;
+	auto const pixels = make_random_pixels<test_pixel<uint8_t, srgb_intensity_mapping, 4>>(w, h);
+	auto const iset = slideproj::image_file_loader::get_supported_instruction_set();
+	auto const layout = slideproj::image_file_loader::make_output_layout(
+		slideproj::image_file_loader::pixel_ordering::top_to_bottom_right_to_left,
+		w/scaling_factor,
+		h/scaling_factor
+	);
+	auto const expected = slideproj::image_file_loader::downsample_to_linear_rgba(
+		pixels.get(), w, h, scaling_factor, layout, true, iset
+	);
+	auto const res_srgb8 = slideproj::image_file_loader::downsample_to_linear_rgba<rgba8_srgb_pixel>(
+		pixels.get(), w, h, scaling_factor, layout, true, iset
+	);
+	auto const res_rgba16f = slideproj::image_file_loader::downsample_to_linear_rgba<rgba16f_pixel>(
+		pixels.get(), w, h, scaling_factor, layout, true, iset
+	);
+	REQUIRE_EQ(res_srgb8.width(), expected.width());
+	REQUIRE_EQ(res_srgb8.height(), expected.height());
+	REQUIRE_EQ(res_rgba16f.width(), expected.width());
+	REQUIRE_EQ(res_rgba16f.height(), expected.height());
+
+	for(size_t k = 0; k != expected.pixel_count(); ++k)
+	{
+		auto const a = res_srgb8.pixels()[k];
+		auto const b = make_pixel_from_linear<rgba8_srgb_pixel>(expected.pixels()[k]);
+		EXPECT_EQ(a.red.value, b.red.value);
+		EXPECT_EQ(a.green.value, b.green.value);
+		EXPECT_EQ(a.blue.value, b.blue.value);
+		EXPECT_EQ(a.alpha.value, b.alpha.value);
+
+		auto const c = res_rgba16f.pixels()[k];
+		auto const d = expected.pixels()[k];
+		EXPECT_LT(std::abs(static_cast<float>(c.red) - d.red), 1.0e-3f);
+		EXPECT_LT(std::abs(static_cast<float>(c.alpha) - d.alpha), 1.0e-3f);
+	}
+}
+
+TESTCASE(slideproj_image_file_loader_downsample_to_linear_rgba_parallel)
+{
+	using slideproj::pixel_store::srgb_intensity_mapping;
+	constexpr uint32_t w = 61;
+	constexpr uint32_t h = 83;
+	constexpr uint32_t scaling_factor = 2;
+	auto const pixels = make_random_pixels<test_pixel<uint8_t, srgb_intensity_mapping, 4>>(w, h);
+	auto const iset = slideproj::image_file_loader::get_supported_instruction_set();
+	slideproj::utils::thread_pool workers{3};
+	for(int k = 0; k != 8; ++k)
+	{
+		auto const layout = slideproj::image_file_loader::make_output_layout(
+			static_cast<slideproj::image_file_loader::pixel_ordering>(k),
+			w/scaling_factor,
+			h/scaling_factor
+		);
+		auto const expected = slideproj::image_file_loader::downsample_to_linear_rgba(
+			pixels.get(), w, h, scaling_factor, layout, true, iset
+		);
+
+		// NOTE: Rows must stay valid within a batch only, so hand out copies that are overwritten
+		//       for every batch
+		constexpr uint32_t rows_per_batch = 11;
+		std::vector<test_pixel<uint8_t, srgb_intensity_mapping, 4>> batch(rows_per_batch*scaling_factor*w);
+		auto const res = slideproj::image_file_loader::downsample_to_linear_rgba<slideproj::pixel_store::rgba_pixel>(
+			[&batch, &pixels](uint32_t y) {
+				auto const rows_per_output_row = static_cast<size_t>(w)*scaling_factor;
+				auto const dest = std::data(batch) + (y%rows_per_batch)*rows_per_output_row;
+				std::copy_n(pixels.get() + y*rows_per_output_row, rows_per_output_row, dest);
+				return static_cast<test_pixel<uint8_t, srgb_intensity_mapping, 4> const*>(dest);
+			},
+			w, h, scaling_factor, layout, true, iset,
+			rows_per_batch,
+			[&workers](size_t item_count, auto&& func) {
+				workers.parallel_for(item_count, slideproj::utils::work_priority::foreground, func);
+			}
+		);
+		REQUIRE_EQ(res.width(), expected.width());
+		REQUIRE_EQ(res.height(), expected.height());
+		EXPECT_EQ(memcmp(res.pixels(), expected.pixels(), expected.pixel_count()*sizeof(slideproj::pixel_store::rgba_pixel)), 0);
+	}
+}
@@ -0,0 +1,225 @@
+//@	{"target": {"name":"image_file_index.o"}}
+
+#include "./image_file_index.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	constexpr std::array<char, 8> index_magic{'S', 'P', 'S', 'C', 'I', 'D', 'X', '\0'};
+	constexpr uint32_t index_version = 3;
+
+	template<class T>
+	requires(std::is_trivially_copyable_v<T>)
+	void write_value(std::ostream& output, T const& value)
+	{ output.write(reinterpret_cast<char const*>(&value), sizeof(value)); }
+
+	class index_reader
+	{
+	public:
+		explicit index_reader(std::span<char const> data):m_data{data}
+		{}
+
+		template<class T>
+		requires(std::is_trivially_copyable_v<T>)
+		T read_value()
+		{
+			T ret;
+			memcpy(&ret, read_bytes(sizeof(T)).data(), sizeof(T));
+			return ret;
+		}
+
+		std::span<char const> read_bytes(size_t count)
+		{
+			if(count > std::size(m_data))
+			{ throw std::runtime_error{"Truncated index file"}; }
+
+			auto const ret = m_data.first(count);
+			m_data = m_data.subspan(count);
+			return ret;
+		}
+
+	private:
+		std::span<char const> m_data;
+	};
+
+	std::vector<char> read_file(std::filesystem::path const& src)
+	{
+		std::ifstream input{src, std::ios::binary};
+		if(!input.is_open())
+		{ return std::vector<char>{}; }
+
+		return std::vector<char>{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+	}
+}
+
+size_t slideproj::image_file_loader::file_key_hash::operator()(file_key const& key) const
+{
+	auto const mtime = static_cast<unsigned __int128>(key.mtime.time_since_epoch().count());
+	auto ret = std::hash<uint64_t>{}(key.device);
+	for(auto value : {key.inode, key.size, static_cast<uint64_t>(mtime), static_cast<uint64_t>(mtime >> 64)})
+	{ ret ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15 + (ret << 6) + (ret >> 2); }
+	return ret;
+}
+
+std::optional<slideproj::image_file_loader::file_status>
+slideproj::image_file_loader::get_file_status(std::filesystem::path const& path)
+{
+	struct statx statxbuf{};
+	auto const res = statx(
+		AT_FDCWD,
+		path.c_str(),
+		AT_NO_AUTOMOUNT,
+		STATX_INO | STATX_SIZE | STATX_MTIME | STATX_BTIME,
+		&statxbuf
+	);
+	if(res == -1 || !(statxbuf.stx_mask & STATX_MTIME))
+	{ return std::nullopt; }
+
+	auto const mtime = file_collector::file_clock::create(statxbuf.stx_mtime);
+	return file_status{
+		.key = file_key{
+			.device = makedev(statxbuf.stx_dev_major, statxbuf.stx_dev_minor),
+			.inode = statxbuf.stx_ino,
+			.size = statxbuf.stx_size,
+			.mtime = mtime
+		},
+		.timestamp = (statxbuf.stx_mask & STATX_BTIME)?
+			file_collector::file_clock::create(statxbuf.stx_btime) :
+			mtime
+	};
+}
+
+slideproj::image_file_loader::image_file_index::image_file_index(std::filesystem::path const& src)
+{
+	auto const data = read_file(src);
+	if(data.empty())
+	{ return; }
+
+	try
+	{
+		index_reader reader{data};
+		auto const magic = reader.read_bytes(std::size(index_magic));
+		if(!std::ranges::equal(magic, index_magic) || reader.read_value<uint32_t>() != index_version)
+		{ return; }
+
+		auto const entry_count = reader.read_value<uint64_t>();
+		for(uint64_t k = 0; k != entry_count; ++k)
+		{
+			file_key key{};
+			key.device = reader.read_value<uint64_t>();
+			key.inode = reader.read_value<uint64_t>();
+			key.size = reader.read_value<uint64_t>();
+			key.mtime = reader.read_value<file_collector::file_clock::time_point>();
+			image_file_index_entry value{};
+			value.valid_fields = reader.read_value<uint32_t>();
+			value.dimensions = reader.read_value<pixel_store::image_rectangle>();
+			value.channel_count = reader.read_value<uint32_t>();
+			value.sample_type = reader.read_value<int32_t>();
+			value.orientation = reader.read_value<int32_t>();
+			value.exif_timestamp = reader.read_value<file_collector::file_clock::time_point>();
+			auto const description_length = reader.read_value<uint32_t>();
+			auto const description = reader.read_bytes(description_length);
+			value.exif_description.assign(std::begin(description), std::end(description));
+			auto const last_used = reader.read_value<std::chrono::sys_seconds>();
+			m_entries.insert(std::pair{key, entry{.value = std::move(value), .last_used = last_used, .used = false}});
+		}
+	}
+	catch(std::exception const& err)
+	{
+		fprintf(stderr, "(!) Ignoring invalid scan index %s: %s\n", src.c_str(), err.what());
+		m_entries.clear();
+	}
+}
+
+std::optional<slideproj::image_file_loader::image_file_index_entry>
+slideproj::image_file_loader::image_file_index::find(file_key const& key) const
+{
+	std::lock_guard lock{m_mutex};
+	auto const i = m_entries.find(key);
+	if(i == std::end(m_entries))
+	{ return std::nullopt; }
+
+	i->second.used = true;
+	return i->second.value;
+}
+
+void slideproj::image_file_loader::image_file_index::save(
+	std::filesystem::path const& dest,
+	std::chrono::sys_seconds now
+) const
+{
+	// Write to a temporary file first, so an interrupted save does not destroy the index. The name
+	// is unique, so concurrent saves do not write to the same file.
+	auto tmp_name = dest;
+	tmp_name += ".XXXXXX";
+	std::string tmp_name_buffer{tmp_name};
+	auto const fd = mkstemp(std::data(tmp_name_buffer));
+	if(fd == -1)
+	{ throw std::runtime_error{std::format("Failed to save scan index to {}: {}", dest.c_str(), strerror(errno))}; }
+	close(fd);
+	tmp_name = tmp_name_buffer;
+
+	try
+	{
+		std::ofstream output{tmp_name, std::ios::binary};
+		if(!output.is_open())
+		{ throw std::runtime_error{std::format("Failed to save scan index to {}", tmp_name.c_str())}; }
+
+		std::lock_guard lock{m_mutex};
+		auto const keep = [now](entry const& item){ return item.used || now - item.last_used <= max_age; };
+		auto const entry_count = static_cast<uint64_t>(
+			std::ranges::count_if(m_entries, [keep](auto const& item){ return keep(item.second); })
+		);
+
+		output.write(std::data(index_magic), std::size(index_magic));
+		write_value(output, index_version);
+		write_value(output, entry_count);
+		for(auto const& item : m_entries)
+		{
+			if(!keep(item.second))
+			{ continue; }
+
+			auto const& key = item.first;
+			auto const& value = item.second.value;
+			write_value(output, key.device);
+			write_value(output, key.inode);
+			write_value(output, key.size);
+			write_value(output, key.mtime);
+			write_value(output, value.valid_fields);
+			write_value(output, value.dimensions);
+			write_value(output, value.channel_count);
+			write_value(output, static_cast<int32_t>(value.sample_type));
+			write_value(output, static_cast<int32_t>(value.orientation));
+			write_value(output, value.exif_timestamp);
+			write_value(output, static_cast<uint32_t>(std::size(value.exif_description)));
+			output.write(std::data(value.exif_description), std::ssize(value.exif_description));
+			write_value(output, item.second.used? now : item.second.last_used);
+		}
+
+		if(!output.flush())
+		{ throw std::runtime_error{std::format("Failed to save scan index to {}", tmp_name.c_str())}; }
+		output.close();
+		std::filesystem::rename(tmp_name, dest);
+	}
+	catch(...)
+	{
+		std::error_code ec;
+		std::filesystem::remove(tmp_name, ec);
+		throw;
+	}
+}
@@ -0,0 +1,109 @@
+//@	{"dependencies_extra":[{"ref":"./image_file_index.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_IMAGE_FILE_LOADER_IMAGE_FILE_INDEX_HPP
+#define SLIDEPROJ_IMAGE_FILE_LOADER_IMAGE_FILE_INDEX_HPP
+
+#include "src/file_collector/file_collector.hpp"
+#include "src/pixel_store/basic_image.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace slideproj::image_file_loader
+{
+	struct file_key
+	{
+		uint64_t device;
+		uint64_t inode;
+		uint64_t size;
+		file_collector::file_clock::time_point mtime;
+
+		bool operator==(file_key const&) const = default;
+		bool operator!=(file_key const&) const = default;
+	};
+
+	struct file_key_hash
+	{
+		size_t operator()(file_key const& key) const;
+	};
+
+	struct file_status
+	{
+		file_key key;
+		file_collector::file_clock::time_point timestamp;
+	};
+
+	std::optional<file_status> get_file_status(std::filesystem::path const& path);
+
+	// NOTE: Only data that only depends on file contents is stored. Data that depends on the path,
+	//       such as the stem used as fallback caption, must be recomputed, since renaming a file does
+	//       not change its key.
+	struct image_file_index_entry
+	{
+		static constexpr uint32_t header_valid = 0x1;
+		static constexpr uint32_t exif_timestamp_valid = 0x2;
+		static constexpr uint32_t exif_description_valid = 0x4;
+
+		uint32_t valid_fields = 0;
+		pixel_store::image_rectangle dimensions{};
+		uint32_t channel_count = 0;
+		int sample_type = -1;
+		int orientation = 0;
+		file_collector::file_clock::time_point exif_timestamp{};
+		std::string exif_description;
+	};
+
+	class image_file_index
+	{
+	public:
+		image_file_index() = default;
+
+		// NOTE: If src does not exist, or is not a valid index, the index will be empty
+		explicit image_file_index(std::filesystem::path const& src);
+
+		std::optional<image_file_index_entry> find(file_key const& key) const;
+
+		template<class Callable>
+		void update(file_key const& key, Callable&& func)
+		{
+			std::lock_guard lock{m_mutex};
+			auto& item = m_entries[key];
+			item.used = true;
+			std::forward<Callable>(func)(item.value);
+		}
+
+		// NOTE: Entries that have not been looked up or updated for max_age are dropped when saving.
+		//       Entries for other directories are kept, so the index can be shared between file
+		//       lists, while entries for files that have been removed or changed eventually expire.
+		static constexpr std::chrono::days max_age{90};
+
+		void save(std::filesystem::path const& dest, std::chrono::sys_seconds now) const;
+
+		void save(std::filesystem::path const& dest) const
+		{ save(dest, std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now())); }
+
+		size_t size() const
+		{
+			std::lock_guard lock{m_mutex};
+			return std::size(m_entries);
+		}
+
+	private:
+		struct entry
+		{
+			image_file_index_entry value;
+			std::chrono::sys_seconds last_used;
+			bool used;
+		};
+
+		mutable std::mutex m_mutex;
+		mutable std::unordered_map<file_key, entry, file_key_hash> m_entries;
+	};
+}
+
+#endif
@@ -0,0 +1,113 @@
+//@	{"target":{"name":"image_file_index.test"}}
+
+#include "./image_file_index.hpp"
+
+#include "testfwk/testfwk.hpp"
+#include "testfwk/validation.hpp"
+
+#include <filesystem>
+
+TESTCASE(slideproj_image_file_loader_get_file_status)
+{
+	auto const status_a = slideproj::image_file_loader::get_file_status("testdata/rgba_8bit_srgb.png");
+	REQUIRE_EQ(status_a.has_value(), true);
+	EXPECT_EQ(status_a->key.size, std::filesystem::file_size("testdata/rgba_8bit_srgb.png"));
+
+	auto const status_b = slideproj::image_file_loader::get_file_status("testdata/rgba_8bit_srgb.bmp");
+	REQUIRE_EQ(status_b.has_value(), true);
+	EXPECT_NE(status_a->key, status_b->key);
+
+	auto const status_c = slideproj::image_file_loader::get_file_status("testdata/non_existing_file.png");
+	EXPECT_EQ(status_c.has_value(), false);
+}
+
+TESTCASE(slideproj_image_file_loader_image_file_index_save_and_load)
+{
+	using slideproj::image_file_loader::image_file_index_entry;
+	using slideproj::image_file_loader::file_key;
+	using slideproj::file_collector::file_clock;
+	using slideproj::image_file_loader::image_file_index;
+
+	constexpr std::chrono::sys_seconds t0{std::chrono::seconds{1760000000}};
+	constexpr auto max_age = image_file_index::max_age;
+	auto const filename = std::filesystem::temp_directory_path()/"slideproj_image_file_index_test.dat";
+	file_key const key_a{
+		.device = 1,
+		.inode = 2,
+		.size = 3,
+		.mtime = file_clock::time_point{std::chrono::seconds{1643220649}}
+	};
+	file_key const key_b{
+		.device = 1,
+		.inode = 3,
+		.size = 3,
+		.mtime = file_clock::time_point{std::chrono::seconds{1643220649}}
+	};
+	file_key const key_unused{
+		.device = 1,
+		.inode = 4,
+		.size = 3,
+		.mtime = file_clock::time_point{std::chrono::seconds{1643220649}}
+	};
+
+	{
+		slideproj::image_file_loader::image_file_index index;
+		index.update(key_a, [](image_file_index_entry& item){
+			item.valid_fields = image_file_index_entry::header_valid
+				| image_file_index_entry::exif_description_valid;
+			item.dimensions = slideproj::pixel_store::image_rectangle{.width = 6000, .height = 4000};
+			item.channel_count = 3;
+			item.sample_type = 1;
+			item.orientation = 8;
+			item.exif_description = "This is a test";
+		});
+		index.update(key_b, [](image_file_index_entry& item){
+			item.valid_fields = image_file_index_entry::exif_timestamp_valid;
+			item.exif_timestamp = file_clock::time_point{std::chrono::seconds{1692772825}};
+		});
+		index.save(filename, t0);
+	}
+
+	{
+		slideproj::image_file_loader::image_file_index index{filename};
+		EXPECT_EQ(index.size(), 2);
+
+		auto const entry_a = index.find(key_a);
+		REQUIRE_EQ(entry_a.has_value(), true);
+		EXPECT_EQ(entry_a->dimensions.width, 6000);
+		EXPECT_EQ(entry_a->dimensions.height, 4000);
+		EXPECT_EQ(entry_a->channel_count, 3);
+		EXPECT_EQ(entry_a->sample_type, 1);
+		EXPECT_EQ(entry_a->orientation, 8);
+		EXPECT_EQ(entry_a->exif_description, "This is a test");
+
+		auto const entry_b = index.find(key_b);
+		REQUIRE_EQ(entry_b.has_value(), true);
+		EXPECT_EQ(entry_b->valid_fields & image_file_index_entry::header_valid, 0);
+		EXPECT_EQ(entry_b->exif_timestamp, file_clock::time_point{std::chrono::seconds{1692772825}});
+
+		EXPECT_EQ(index.find(key_unused).has_value(), false);
+	}
+
+	{
+		// Entries that have not been used are kept until they expire
+		slideproj::image_file_loader::image_file_index index{filename};
+		EXPECT_EQ(index.find(key_b).has_value(), true);
+		index.save(filename, t0 + std::chrono::days{1});
+	}
+
+	{
+		slideproj::image_file_loader::image_file_index index{filename};
+		EXPECT_EQ(index.size(), 2);
+		index.save(filename, t0 + max_age + std::chrono::days{1});
+	}
+
+	{
+		slideproj::image_file_loader::image_file_index index{filename};
+		EXPECT_EQ(index.size(), 1);
+		EXPECT_EQ(index.find(key_a).has_value(), false);
+		EXPECT_EQ(index.find(key_b).has_value(), true);
+	}
+
+	std::filesystem::remove(filename);
+}
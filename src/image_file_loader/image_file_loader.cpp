@@ -4,6 +4,8 @@
 //@	}
 
 #include "./image_file_loader.hpp"
+#include "./downsample.hpp"
+#include "./resample.hpp"
 
 #include "src/file_collector/file_collector.hpp"
 #include "src/pixel_store/rgba_image.hpp"
@@ -11,12 +13,16 @@
 #include <OpenImageIO/typedesc.h>
 #include <OpenImageIO/ustring.h>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <linux/stat.h>
 #include <memory>
+#include <numeric>
 #include <ranges>
 #include <stdexcept>
+#include <type_traits>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/imagebuf.h>
 #include <ctime>
 
 std::optional<std::array<int, 6>>
@@ -135,16 +141,37 @@ slideproj::image_file_loader::exif_query_result::exif_query_result(OIIO::ImageSp
 	// field
 }
 
+slideproj::image_file_loader::exif_query_result::exif_query_result(
+	image_file_index_entry const& index_entry
+):
+	m_valid_fields{0}
+{
+	if(index_entry.valid_fields & image_file_index_entry::exif_timestamp_valid)
+	{
+		m_valid_fields |= timestamp_valid;
+		m_timestamp = index_entry.exif_timestamp;
+	}
+
+	if(index_entry.valid_fields & image_file_index_entry::exif_description_valid)
+	{
+		m_valid_fields |= description_valid;
+		m_description = index_entry.exif_description;
+	}
+}
+
 slideproj::image_file_loader::image_file_info
-slideproj::image_file_loader::load_metadata(std::filesystem::path const& path)
+slideproj::image_file_loader::make_image_file_info(
+	std::filesystem::path const& path,
+	exif_query_result const& exif_info,
+	file_collector::file_clock::time_point fs_timestamp
+)
 {
-	auto const exif_info = load_exif_query_result(path);
 	image_file_info ret{};
 	ret.timestamp = exif_info.timestamp() != nullptr?
 			*exif_info.timestamp()
 			// TODO: It is maybe better to let file_collector set the timestamp itself, is we cannot
 			//       get a value from exif
-			: file_collector::get_timestamp(path).value_or(file_collector::file_clock::time_point{});
+			: fs_timestamp;
 	ret.caption = exif_info.description() != nullptr?
 			*exif_info.description():
 			path.stem().string();
@@ -153,36 +180,197 @@ slideproj::image_file_loader::load_metadata(std::filesystem::path const& path)
 	return ret;
 }
 
-slideproj::image_file_loader::image_file_info const&
+namespace
+{
+	slideproj::pixel_store::image_rectangle get_dimensions(OIIO::ImageSpec const& spec)
+	{
+		if(spec.width <= 0 || spec.height <= 0)
+		{ return slideproj::pixel_store::image_rectangle{}; }
+
+		return slideproj::pixel_store::image_rectangle{
+			.width = static_cast<uint32_t>(spec.width),
+			.height = static_cast<uint32_t>(spec.height)
+		};
+	}
+
+	auto read_image_file_header(std::filesystem::path const& path)
+	{
+		// NOTE: Only the pages that hold the header are read from the mapping
+		slideproj::image_file_loader::image_file const file{path, slideproj::utils::mapped_file_mode::on_demand};
+		if(file.input() == nullptr)
+		{ return slideproj::image_file_loader::image_file_header{}; }
+
+		return slideproj::image_file_loader::make_image_file_header(file.input()->spec());
+	}
+
+	auto to_image_file_header(slideproj::image_file_loader::image_file_index_entry const& entry)
+	{
+		return slideproj::image_file_loader::image_file_header{
+			.dimensions = entry.dimensions,
+			.channel_count = entry.channel_count,
+			.sample_type = static_cast<slideproj::image_file_loader::sample_value_type_id>(entry.sample_type),
+			.orientation = entry.orientation,
+			.exif = slideproj::image_file_loader::exif_query_result{entry},
+			.fs_timestamp = slideproj::file_collector::file_clock::time_point{}
+		};
+	}
+
+	void store(
+		slideproj::image_file_loader::image_file_header const& header,
+		slideproj::image_file_loader::image_file_index_entry& entry
+	)
+	{
+		using slideproj::image_file_loader::image_file_index_entry;
+		entry.valid_fields = image_file_index_entry::header_valid;
+		entry.dimensions = header.dimensions;
+		entry.channel_count = static_cast<uint32_t>(header.channel_count);
+		entry.sample_type = static_cast<int>(header.sample_type);
+		entry.orientation = header.orientation;
+		if(auto const timestamp = header.exif.timestamp(); timestamp != nullptr)
+		{
+			entry.valid_fields |= image_file_index_entry::exif_timestamp_valid;
+			entry.exif_timestamp = *timestamp;
+		}
+
+		if(auto const description = header.exif.description(); description != nullptr)
+		{
+			entry.valid_fields |= image_file_index_entry::exif_description_valid;
+			entry.exif_description = *description;
+		}
+	}
+}
+
+slideproj::image_file_loader::image_file_header
+slideproj::image_file_loader::make_image_file_header(OIIO::ImageSpec const& spec)
+{
+	return image_file_header{
+		.dimensions = ::get_dimensions(spec),
+		.channel_count = static_cast<size_t>(std::max(spec.nchannels, 0)),
+		.sample_type = to_value_type_id(spec.format),
+		.orientation = spec.get_int_attribute("Orientation"),
+		.exif = exif_query_result{spec},
+		.fs_timestamp = file_collector::file_clock::time_point{}
+	};
+}
+
+slideproj::image_file_loader::image_file_header
+slideproj::image_file_loader::probe_image_file(std::filesystem::path const& path)
+{
+	auto ret = read_image_file_header(path);
+	if(ret.exif.timestamp() == nullptr)
+	{ ret.fs_timestamp = file_collector::get_timestamp(path).value_or(file_collector::file_clock::time_point{}); }
+	return ret;
+}
+
+slideproj::file_collector::file_metadata
 slideproj::image_file_loader::image_file_metadata_repository::get_metadata(
 	file_collector::file_list_entry const& entry
 ) const
 {
-	auto i = m_cache.find(entry.id());
-	if(i != std::end(m_cache))
-	{ return i->second; }
+	{
+		std::lock_guard lock{m_metadata_mutex};
+		auto const ret = m_metadata.find(entry.id());
+		if(ret.has_value())
+		{ return *ret; }
+	}
+
+	auto const path = entry.path();
+	auto const header = [this, &path]() {
+		std::unique_lock lock{m_headers_mutex};
+		auto node = m_headers.extract(path.native());
+		lock.unlock();
+		return node.empty()? probe(path) : std::move(node.mapped());
+	}();
+
+	auto const info = make_image_file_info(path, header);
+	std::lock_guard lock{m_metadata_mutex};
+	m_metadata.insert(
+		entry.id(),
+		file_collector::file_metadata{
+			.timestamp = info.timestamp,
+			.in_group = info.in_group,
+			.caption = info.caption
+		}
+	);
+	return *m_metadata.find(entry.id());
+}
+
+slideproj::image_file_loader::image_file_header
+slideproj::image_file_loader::image_file_metadata_repository::get_header(
+	std::filesystem::path const& path
+) const
+{
+	{
+		std::lock_guard lock{m_headers_mutex};
+		auto const i = m_headers.find(path.native());
+		if(i != std::end(m_headers))
+		{ return i->second; }
+	}
 
-	return m_cache.insert(std::pair{entry.id(), load_metadata(entry.path())}).first->second;
+	auto header = probe(path);
+	std::lock_guard lock{m_headers_mutex};
+	return m_headers.insert(std::pair{path.native(), std::move(header)}).first->second;
 }
 
-slideproj::pixel_store::image_rectangle
-slideproj::image_file_loader::image_file_metadata_repository::get_dimensions(
+void slideproj::image_file_loader::image_file_metadata_repository::discard_header(
 	std::filesystem::path const& path
+) const
+{
+	std::lock_guard lock{m_headers_mutex};
+	m_headers.erase(path.native());
+}
+
+slideproj::image_file_loader::image_file_header
+slideproj::image_file_loader::image_file_metadata_repository::probe(
+	std::filesystem::path const& path
+) const
+{
+	auto const status = m_index != nullptr? get_file_status(path) : std::nullopt;
+	if(!status.has_value())
+	{ return probe_image_file(path); }
+
+	auto const index_entry = m_index->find(status->key);
+	if(index_entry.has_value() && (index_entry->valid_fields & image_file_index_entry::header_valid))
+	{
+		auto ret = to_image_file_header(*index_entry);
+		ret.fs_timestamp = status->timestamp;
+		return ret;
+	}
+
+	auto ret = read_image_file_header(path);
+	m_index->update(status->key, [&ret](image_file_index_entry& item) { store(ret, item); });
+	ret.fs_timestamp = status->timestamp;
+	return ret;
+}
+
+slideproj::image_file_loader::image_file::image_file(
+	std::filesystem::path const& path,
+	utils::mapped_file_mode mode
 )
 {
-	auto input = OIIO::ImageInput::open(path);
-	if(input == nullptr)
-	{ return pixel_store::image_rectangle{}; }
+	OIIO::ImageSpec spec_in;
+	spec_in.attribute("oiio:UnassociatedAlpha", 1);
 
-	auto const& spec = input->spec();
+	auto const read_start = std::chrono::steady_clock::now();
+	try
+	{ m_data = utils::mapped_file{path, mode}; }
+	catch(std::runtime_error const&)
+	{
+		// NOTE: The file could not be mapped or read in advance. Let OIIO open it by itself.
+		m_input = OIIO::ImageInput::open(path, &spec_in);
+		return;
+	}
+	m_read_time = std::chrono::steady_clock::now() - read_start;
 
-	if(spec.width <= 0 || spec.height <= 0)
-	{ return pixel_store::image_rectangle{}; }
+	auto const data = m_data.data();
+	m_io_proxy = std::make_unique<OIIO::Filesystem::IOMemReader>(std::data(data), std::size(data));
+	m_input = OIIO::ImageInput::open(path, &spec_in, m_io_proxy.get());
+	if(m_input != nullptr)
+	{ return; }
 
-	return pixel_store::image_rectangle{
-		.width = static_cast<uint32_t>(spec.width),
-		.height = static_cast<uint32_t>(spec.height)
-	};
+	m_io_proxy.reset();
+	m_data = utils::mapped_file{};
+	m_input = OIIO::ImageInput::open(path, &spec_in);
 }
 
 slideproj::image_file_loader::loaded_image::loaded_image(
@@ -206,35 +394,401 @@ slideproj::image_file_loader::loaded_image::loaded_image(
 			array_len = static_cast<size_t>(w) * static_cast<size_t>(h)
 		]<class T>(utils::make_variant_type_tag<T>){
 			using elem_type = typename T::element_type;
-			return std::make_unique_for_overwrite<elem_type[]>(array_len);
+			return pixel_store::make_pooled_pixel_buffer<elem_type>(array_len);
 		}
 	);
 	m_width = w;
 	m_height = h;
 }
 
+namespace
+{
+	using namespace slideproj::image_file_loader;
+
+	struct image_decode_info
+	{
+		pixel_type_id pixel_type;
+		enum alpha_mode alpha_mode;
+		uint32_t width;
+		uint32_t height;
+		enum pixel_ordering pixel_ordering;
+
+		bool is_valid() const
+		{
+			return pixel_type.is_valid()
+				&& pixel_ordering != pixel_ordering::invalid
+				&& width != 0
+				&& height != 0;
+		}
+	};
+
+	image_decode_info get_decode_info(OIIO::ImageSpec const& spec)
+	{
+		if(spec.width <= 0 || spec.height <= 0 || spec.nchannels <= 0)
+		{ return image_decode_info{}; }
+
+		return image_decode_info{
+			.pixel_type = pixel_type_id{
+				to_intensity_transfer_function_id(spec.get_string_attribute("OIIO:ColorSpace")),
+				static_cast<size_t>(spec.nchannels),
+				to_value_type_id(spec.format)
+			},
+			.alpha_mode = (spec.nchannels%2 == 0 && spec.get_int_attribute("oiio:UnassociatedAlpha")) == 0?
+				alpha_mode::premultiplied:
+				alpha_mode::straight,
+			.width = static_cast<uint32_t>(spec.width),
+			.height = static_cast<uint32_t>(spec.height),
+			.pixel_ordering = to_pixel_ordering_from_exif_orientation(spec.get_int_attribute("Orientation"))
+		};
+	}
+
+	// Calls cb with std::type_identity<PixelType>, where PixelType is the pixel type identified by
+	// pixel_type
+	template<class Callable>
+	decltype(auto) visit_pixel_type(pixel_type_id pixel_type, Callable&& cb)
+	{
+		return std::visit(
+			[&cb]<class T>(T const&) {
+				return cb(std::type_identity<typename T::element_type>{});
+			},
+			slideproj::utils::make_variant<pixel_buffer>(
+				pixel_type.value(),
+				[]<class T>(slideproj::utils::make_variant_type_tag<T>){ return T{}; }
+			)
+		);
+	}
+
+	// NOTE: Row sources hand out this many output rows at a time, so a batch is large enough to keep
+	//       all workers busy while it is processed
+	constexpr uint32_t min_output_rows_per_batch = 64;
+
+	// Row source for the downsampler, for images that are already in memory
+	template<class PixelType>
+	struct in_memory_row_source
+	{
+		PixelType const* pixels;
+		size_t pixels_per_output_row;
+
+		uint32_t rows_per_batch() const
+		{ return min_output_rows_per_batch; }
+
+		PixelType const* operator()(uint32_t y) const
+		{ return pixels + y*pixels_per_output_row; }
+	};
+
+	// Row source for the downsampler, that decodes the image in bands. A band is a multiple of both
+	// the tile height and rows_per_output_row, so reads are tile aligned, and no output row straddles
+	// two bands.
+	template<class PixelType>
+	class band_reader
+	{
+	public:
+		explicit band_reader(
+			OIIO::ImageInput& input,
+			uint32_t rows_per_output_row,
+			std::stop_token stop_token = std::stop_token{}
+		):
+			m_input{input},
+			m_stop_token{std::move(stop_token)},
+			m_rows_per_output_row{rows_per_output_row},
+			m_band_begin{0},
+			m_band_end{0}
+		{
+			auto const& spec = input.spec();
+			auto const tile_height = spec.tile_width != 0? static_cast<uint32_t>(spec.tile_height) : 1u;
+			auto const step = std::lcm(rows_per_output_row, tile_height);
+			auto const min_band_height = min_output_rows_per_batch*rows_per_output_row;
+			m_band_height = std::min(
+				step*((min_band_height + step - 1)/step),
+				static_cast<uint32_t>(spec.height)
+			);
+			m_band = slideproj::pixel_store::make_pooled_pixel_buffer<PixelType>(
+				static_cast<size_t>(spec.width)*m_band_height
+			);
+		}
+
+		// NOTE: Bands start at multiples of the band height, so all output rows of a band are
+		//       valid at the same time
+		uint32_t rows_per_batch() const
+		{ return m_band_height/m_rows_per_output_row; }
+
+		PixelType const* operator()(uint32_t y)
+		{
+			auto const y_in = y*m_rows_per_output_row;
+			if(y_in + m_rows_per_output_row > m_band_end)
+			{
+				// NOTE: Checking between bands is enough to give up within milliseconds, also for
+				//       large images
+				slideproj::utils::throw_if_stop_requested(m_stop_token);
+				read_band(y_in);
+			}
+			return m_band.get() + static_cast<size_t>(y_in - m_band_begin)*static_cast<size_t>(m_input.spec().width);
+		}
+
+	private:
+		void read_band(uint32_t begin)
+		{
+			auto const& spec = m_input.spec();
+			m_band_begin = begin;
+			m_band_end = std::min(begin + m_band_height, static_cast<uint32_t>(spec.height));
+			auto const y_begin = spec.y + static_cast<int>(m_band_begin);
+			auto const y_end = spec.y + static_cast<int>(m_band_end);
+			if(spec.tile_width != 0)
+			{
+				m_input.read_tiles(
+					m_input.current_subimage(),
+					m_input.current_miplevel(),
+					spec.x, spec.x + spec.width,
+					y_begin, y_end,
+					spec.z, spec.z + std::max(spec.depth, 1),
+					0, spec.nchannels,
+					spec.format,
+					m_band.get()
+				);
+			}
+			else
+			{
+				m_input.read_scanlines(
+					m_input.current_subimage(),
+					m_input.current_miplevel(),
+					y_begin, y_end,
+					spec.z,
+					0, spec.nchannels,
+					spec.format,
+					m_band.get()
+				);
+			}
+		}
+
+		OIIO::ImageInput& m_input;
+		std::stop_token m_stop_token;
+		uint32_t m_rows_per_output_row;
+		uint32_t m_band_height;
+		uint32_t m_band_begin;
+		uint32_t m_band_end;
+		slideproj::pixel_store::pooled_pixel_buffer<PixelType> m_band;
+	};
+
+	// Loads the embedded thumbnail, if it has the same aspect ratio as the image, and is at least
+	// min_size. min_size is in file orientation.
+	loaded_image load_thumbnail(
+		OIIO::ImageInput& input,
+		image_decode_info const& info,
+		slideproj::pixel_store::image_rectangle min_size
+	)
+	{
+		auto const& spec = input.spec();
+		auto const thumbnail_width = spec.get_int_attribute("thumbnail_width");
+		auto const thumbnail_height = spec.get_int_attribute("thumbnail_height");
+		if(thumbnail_width <= 0 || thumbnail_height <= 0)
+		{ return loaded_image{}; }
+
+		if(static_cast<uint32_t>(thumbnail_width) < min_size.width
+			|| static_cast<uint32_t>(thumbnail_height) < min_size.height)
+		{ return loaded_image{}; }
+
+		// NOTE: Some cameras pad the thumbnail to 4:3, which would show up as black borders
+		auto const aspect_ratio_error = std::abs(
+			static_cast<double>(thumbnail_width)*static_cast<double>(info.height)
+				- static_cast<double>(thumbnail_height)*static_cast<double>(info.width)
+		);
+		if(aspect_ratio_error > 0.01*static_cast<double>(thumbnail_height)*static_cast<double>(info.width))
+		{ return loaded_image{}; }
+
+		OIIO::ImageBuf thumbnail;
+		if(!input.get_thumbnail(thumbnail, input.current_subimage()))
+		{ return loaded_image{}; }
+
+		auto const thumbnail_info = get_decode_info(thumbnail.spec());
+		if(!thumbnail_info.is_valid())
+		{ return loaded_image{}; }
+
+		// NOTE: The thumbnail is stored in file orientation, like the image itself
+		loaded_image ret{
+			thumbnail_info.pixel_type,
+			thumbnail_info.alpha_mode,
+			thumbnail_info.width,
+			thumbnail_info.height,
+			info.pixel_ordering,
+			slideproj::pixel_store::make_uninitialized_pixel_buffer_tag{}
+		};
+		if(ret.is_empty())
+		{ return ret; }
+
+		auto const res = ret.visit([&thumbnail](auto pixel_buffer, auto&&...) {
+			return thumbnail.get_pixels(OIIO::ROI::All(), thumbnail.spec().format, pixel_buffer);
+		});
+		return res? std::move(ret) : loaded_image{};
+	}
+
+	// Seeks to the smallest MIP level that is at least min_size. min_size is in file orientation.
+	// Returns true if another level than the current one was selected.
+	bool seek_to_mip_level(OIIO::ImageInput& input, slideproj::pixel_store::image_rectangle min_size)
+	{
+		auto const subimage = input.current_subimage();
+		auto level = input.current_miplevel();
+		auto current = input.spec_dimensions(subimage, level);
+		while(true)
+		{
+			auto const next = input.spec_dimensions(subimage, level + 1);
+			if(next.width <= 0 || next.height <= 0)
+			{ break; }
+
+			// NOTE: Guards against files where levels do not get smaller
+			if(next.width >= current.width && next.height >= current.height)
+			{ break; }
+
+			if(static_cast<uint32_t>(next.width) < min_size.width
+				|| static_cast<uint32_t>(next.height) < min_size.height)
+			{ break; }
+			current = next;
+			++level;
+		}
+
+		if(level == input.current_miplevel())
+		{ return false; }
+
+		return input.seek_subimage(subimage, level);
+	}
+
+	// Returns the smallest integer factor that shrinks input to within a factor of 2 from output along
+	// both axes. The factor never takes input below output.
+	uint32_t compute_prescale_factor(
+		slideproj::pixel_store::image_rectangle input,
+		slideproj::pixel_store::image_rectangle output
+	)
+	{
+		if(output.width == 0 || output.height == 0)
+		{ return 1; }
+
+		auto const ceil_div = [](uint64_t a, uint64_t b) { return static_cast<uint32_t>((a + b - 1)/b); };
+		auto const factor = std::max(
+			ceil_div(input.width, 2*static_cast<uint64_t>(output.width)),
+			ceil_div(input.height, 2*static_cast<uint64_t>(output.height))
+		);
+		auto const max_factor = std::min(input.width/output.width, input.height/output.height);
+		return std::clamp(factor, 1u, std::max(max_factor, 1u));
+	}
+
+	// NOTE: make_row_source(scaling_factor) must return a row source for the downsampler, as
+	//       described by for_each_downsampled_rgba_batch, with a rows_per_batch() member
+	template<class OutputPixelType, class RowSourceFactory>
+	slideproj::pixel_store::basic_image<OutputPixelType> make_fitted_rgba_image(
+		RowSourceFactory&& make_row_source,
+		uint32_t w,
+		uint32_t h,
+		enum pixel_ordering pixel_ordering,
+		bool premultiply,
+		slideproj::pixel_store::image_rectangle fit,
+		slideproj::utils::thread_pool& workers,
+		slideproj::utils::work_priority_source priority
+	)
+	{
+		auto const transposed = is_transposed(pixel_ordering);
+		slideproj::pixel_store::image_rectangle const input_size{
+			.width = transposed? h : w,
+			.height = transposed? w : h
+		};
+		auto const output_size = compute_fitted_size(input_size, fit);
+		auto const scaling_factor = compute_scaling_factor(input_size, fit);
+		auto const iset = get_supported_instruction_set();
+		auto const parallel_for = [&workers, priority](size_t item_count, auto&& func) {
+			workers.parallel_for(item_count, priority, func);
+		};
+		if(input_size.width/scaling_factor == output_size.width && input_size.height/scaling_factor == output_size.height)
+		{
+			auto get_rows = make_row_source(scaling_factor);
+			return downsample_to_linear_rgba<OutputPixelType>(
+				get_rows, w, h, scaling_factor,
+				make_output_layout(pixel_ordering, w/scaling_factor, h/scaling_factor),
+				premultiply,
+				iset,
+				get_rows.rows_per_batch(),
+				parallel_for
+			);
+		}
+
+		// NOTE: Box filtering is cheap, but only correct for integer ratios. Use it to get within a
+		//       factor of 2 from the output size, and let the resampler do the rest. Resampling is done
+		//       in file orientation, so rows can be passed on as soon as they have been decoded.
+		auto const prescale = compute_prescale_factor(input_size, output_size);
+		auto const w_prescaled = w/prescale;
+		slideproj::pixel_store::image_rectangle const resampled_size{
+			.width = transposed? output_size.height : output_size.width,
+			.height = transposed? output_size.width : output_size.height
+		};
+		streaming_resampler resampler{
+			slideproj::pixel_store::image_rectangle{.width = w_prescaled, .height = h/prescale},
+			resampled_size,
+			workers,
+			priority
+		};
+
+		auto get_rows = make_row_source(prescale);
+		auto const rows_per_batch = get_rows.rows_per_batch();
+		auto const rows = slideproj::pixel_store::make_pooled_pixel_buffer<slideproj::pixel_store::rgba_pixel>(
+			static_cast<size_t>(std::min(rows_per_batch, h/prescale))*w_prescaled
+		);
+		for_each_downsampled_rgba_batch(
+			get_rows, w, h, prescale, premultiply, iset, rows_per_batch, parallel_for,
+			[&rows, rows_per_batch, w_prescaled](uint32_t y_begin, uint32_t row_count, auto rows_in) {
+				std::copy_n(
+					rows_in,
+					static_cast<size_t>(row_count)*w_prescaled,
+					rows.get() + static_cast<size_t>(y_begin%rows_per_batch)*w_prescaled
+				);
+			},
+			[&rows, &resampler](uint32_t, uint32_t row_count) {
+				resampler.push_rows(rows.get(), row_count);
+			}
+		);
+
+		auto const resampled = std::move(resampler).take_result();
+		auto const layout = make_output_layout(pixel_ordering, resampled.width(), resampled.height());
+		slideproj::pixel_store::basic_image<OutputPixelType> ret{
+			layout.size.width,
+			layout.size.height,
+			slideproj::pixel_store::make_uninitialized_pixel_buffer_tag{}
+		};
+		static constexpr uint32_t rows_per_item = 8;
+		workers.parallel_for(
+			(resampled.height() + rows_per_item - 1)/rows_per_item,
+			priority,
+			[&resampled, &layout, pixels_out = ret.pixels()](size_t item) {
+				auto const y_begin = static_cast<uint32_t>(item)*rows_per_item;
+				auto const row_count = std::min(rows_per_item, resampled.height() - y_begin);
+				auto const row_length = resampled.width();
+				auto const rows_in = resampled.pixels() + static_cast<size_t>(y_begin)*row_length;
+				auto const band = slideproj::pixel_store::make_pooled_pixel_buffer<OutputPixelType>(
+					static_cast<size_t>(row_count)*row_length
+				);
+				std::transform(
+					rows_in,
+					rows_in + static_cast<size_t>(row_count)*row_length,
+					band.get(),
+					slideproj::pixel_store::make_pixel_from_linear<OutputPixelType>
+				);
+				write_oriented_rows(pixels_out, layout, y_begin, row_count, row_length, static_cast<OutputPixelType const*>(band.get()));
+			}
+		);
+		return ret;
+	}
+}
+
 slideproj::image_file_loader::loaded_image
 slideproj::image_file_loader::load_image(OIIO::ImageInput& input)
 {
 	auto const& spec = input.spec();
-	if(spec.width <= 0 || spec.height <= 0 || spec.nchannels <= 0)
+	auto const info = get_decode_info(spec);
+	if(!info.is_valid())
 	{ return loaded_image{}; }
 
-	auto const alpha_mode =
-		(spec.nchannels%2 == 0 && spec.get_int_attribute("oiio:UnassociatedAlpha")) == 0?
-		alpha_mode::premultiplied:
-		alpha_mode::straight;
-
 	loaded_image ret{
-		pixel_type_id{
-			to_intensity_transfer_function_id(spec.get_string_attribute("OIIO:ColorSpace")),
-			static_cast<size_t>(spec.nchannels),
-			to_value_type_id(spec.format)
-		},
-		alpha_mode,
-		static_cast<uint32_t>(spec.width),
-		static_cast<uint32_t>(spec.height),
-		to_pixel_ordering_from_exif_orientation(spec.get_int_attribute("Orientation")),
+		info.pixel_type,
+		info.alpha_mode,
+		info.width,
+		info.height,
+		info.pixel_ordering,
 		pixel_store::make_uninitialized_pixel_buffer_tag{}
 	};
 
@@ -254,62 +808,20 @@ slideproj::image_file_loader::make_linear_rgba_image(
 	uint32_t scaling_factor
 )
 {
-	auto ret = input.visit([
+	// NOTE: Everything is done while downsampling, so only the output image is allocated
+	return input.visit([
 		scaling_factor,
-		pixel_ordering = input.pixel_ordering()
+		pixel_ordering = input.pixel_ordering(),
+		premultiply = input.alpha_mode() == alpha_mode::straight,
+		iset = get_supported_instruction_set()
 	](auto pixels, uint32_t w, uint32_t h) {
-		auto downsampled = downsample_to_linear(pixels, w, h, scaling_factor);
-		if(downsampled.is_empty())
-		{ return pixel_store::rgba_image{}; }
-
-		switch(pixel_ordering)
-		{
-			case pixel_ordering::top_to_bottom_right_to_left:
-				downsampled = apply_pixel_ordering<pixel_ordering::top_to_bottom_right_to_left>(downsampled);
-				break;
-			case pixel_ordering::bottom_to_top_right_to_left:
-				downsampled = apply_pixel_ordering<pixel_ordering::bottom_to_top_right_to_left>(downsampled);
-				break;
-			case pixel_ordering::bottom_to_top_left_to_right:
-				downsampled = apply_pixel_ordering<pixel_ordering::bottom_to_top_left_to_right>(downsampled);
-				break;
-			case pixel_ordering::left_to_right_top_to_bottom:
-				downsampled = apply_pixel_ordering<pixel_ordering::left_to_right_top_to_bottom>(downsampled);
-				break;
-			case pixel_ordering::right_to_left_top_to_bottom:
-				downsampled = apply_pixel_ordering<pixel_ordering::right_to_left_top_to_bottom>(downsampled);
-				break;
-			case pixel_ordering::right_to_left_bottom_to_top:
-				downsampled = apply_pixel_ordering<pixel_ordering::right_to_left_bottom_to_top>(downsampled);
-				break;
-			case pixel_ordering::left_to_right_bottom_to_top:
-				downsampled = apply_pixel_ordering<pixel_ordering::left_to_right_bottom_to_top>(downsampled);
-				break;
-			default:
-				break;
-		}
-		return to_rgba(downsampled.pixels(), downsampled.width(), downsampled.height());
-	});
-
-	if(input.alpha_mode() == alpha_mode::straight)
-	{
-		auto const pixels = ret.pixels();
-		std::transform(
-			pixels, pixels + ret.pixel_count(),
-			pixels,
-			[](auto item){
-				auto const alpha = item.alpha;
-				return slideproj::pixel_store::rgba_pixel{
-					.red = alpha*item.red,
-					.green = alpha*item.green,
-					.blue = alpha*item.blue,
-					.alpha = alpha
-				};
-			}
+		return downsample_to_linear_rgba(
+			pixels, w, h, scaling_factor,
+			make_output_layout(pixel_ordering, w/scaling_factor, h/scaling_factor),
+			premultiply,
+			iset
 		);
-	}
-
-	return ret;
+	});
 }
 
 uint32_t slideproj::image_file_loader::compute_scaling_factor(
@@ -326,24 +838,173 @@ uint32_t slideproj::image_file_loader::compute_scaling_factor(
 	return (input_aspect_ratio >= output_aspect_ratio)? input.width/fit.width : input.height/fit.height;
 }
 
-slideproj::pixel_store::rgba_image
-slideproj::image_file_loader::make_linear_rgba_image(
-	loaded_image const& input,
+slideproj::pixel_store::image_rectangle slideproj::image_file_loader::compute_fitted_size(
+	pixel_store::image_rectangle input,
 	pixel_store::image_rectangle fit
 )
 {
-	auto w_in = input.width();
-	auto h_in = input.height();
-	if(is_transposed(input.pixel_ordering()))
-	{ std::swap(w_in, h_in); }
-
-	return make_linear_rgba_image(
-		input, compute_scaling_factor(
-			pixel_store::image_rectangle{
-				.width = w_in,
-				.height = h_in
+	if(input.width <= fit.width && input.height <= fit.height)
+	{ return input; }
+
+	auto const input_aspect_ratio = static_cast<double>(input.width)/static_cast<double>(input.height);
+	auto const output_aspect_ratio = static_cast<double>(fit.width)/static_cast<double>(fit.height);
+	auto const scale_to = [](uint32_t value, uint32_t to, uint32_t from) {
+		return std::max(
+			static_cast<uint32_t>(std::lround(static_cast<double>(value)*static_cast<double>(to)/static_cast<double>(from))),
+			1u
+		);
+	};
+
+	if(input_aspect_ratio >= output_aspect_ratio)
+	{
+		return pixel_store::image_rectangle{
+			.width = fit.width,
+			.height = scale_to(input.height, fit.width, input.width)
+		};
+	}
+
+	return pixel_store::image_rectangle{
+		.width = scale_to(input.width, fit.height, input.height),
+		.height = fit.height
+	};
+}
+
+namespace
+{
+	template<class OutputPixelType>
+	auto make_fitted_image(
+		loaded_image const& input,
+		slideproj::pixel_store::image_rectangle fit,
+		slideproj::utils::thread_pool& workers,
+		slideproj::utils::work_priority_source priority
+	)
+	{
+		return input.visit([
+			pixel_ordering = input.pixel_ordering(),
+			premultiply = input.alpha_mode() == alpha_mode::straight,
+			fit,
+			&workers,
+			priority
+		](auto pixels, uint32_t w, uint32_t h) {
+			return make_fitted_rgba_image<OutputPixelType>(
+				[pixels, w](uint32_t scaling_factor) {
+					return in_memory_row_source{pixels, static_cast<size_t>(w)*scaling_factor};
+				},
+				w, h, pixel_ordering, premultiply, fit, workers, priority
+			);
+		});
+	}
+
+	template<class OutputPixelType>
+	slideproj::pixel_store::basic_image<OutputPixelType> load_fitted_image(
+		OIIO::ImageInput& input,
+		slideproj::pixel_store::image_rectangle fit,
+		slideproj::utils::thread_pool& workers,
+		slideproj::utils::work_priority_source priority,
+		std::stop_token const& stop_token
+	)
+	{
+		auto info = get_decode_info(input.spec());
+		if(!info.is_valid())
+		{ return slideproj::pixel_store::basic_image<OutputPixelType>{}; }
+
+		auto const transposed = is_transposed(info.pixel_ordering);
+		auto const output_size = compute_fitted_size(
+			slideproj::pixel_store::image_rectangle{
+				.width = transposed? info.height : info.width,
+				.height = transposed? info.width : info.height
 			},
 			fit
-		)
-	);
-}
\ No newline at end of file
+		);
+		slideproj::pixel_store::image_rectangle const min_size{
+			.width = transposed? output_size.height : output_size.width,
+			.height = transposed? output_size.width : output_size.height
+		};
+
+		// NOTE: Prefer the smallest representation stored in the file that is still large enough,
+		//       so there is less to decode. The downsampler takes care of the remaining factor.
+		if(auto const thumbnail = load_thumbnail(input, info, min_size); !thumbnail.is_empty())
+		{ return make_fitted_image<OutputPixelType>(thumbnail, output_size, workers, priority); }
+
+		if(seek_to_mip_level(input, min_size))
+		{
+			// NOTE: Orientation and color space may only be present in the spec of the first level,
+			//       so only the dimensions are taken from the new level
+			info.width = static_cast<uint32_t>(input.spec().width);
+			info.height = static_cast<uint32_t>(input.spec().height);
+			fit = output_size;
+		}
+
+		return visit_pixel_type(
+			info.pixel_type,
+			[&input, &info, fit, &workers, priority, &stop_token]<class PixelType>(std::type_identity<PixelType>) {
+				return make_fitted_rgba_image<OutputPixelType>(
+					[&input, &stop_token](uint32_t scaling_factor) {
+						return band_reader<PixelType>{input, scaling_factor, stop_token};
+					},
+					info.width, info.height, info.pixel_ordering, info.alpha_mode == alpha_mode::straight, fit,
+					workers, priority
+				);
+			}
+		);
+	}
+}
+
+slideproj::pixel_store::rgba_image
+slideproj::image_file_loader::make_linear_rgba_image(
+	loaded_image const& input,
+	pixel_store::image_rectangle fit,
+	utils::thread_pool& workers,
+	utils::work_priority_source priority
+)
+{ return make_fitted_image<pixel_store::rgba_pixel>(input, fit, workers, priority); }
+
+slideproj::pixel_store::rgba_image
+slideproj::image_file_loader::load_rgba_image(OIIO::ImageInput& input, uint32_t scaling_factor)
+{
+	auto const info = get_decode_info(input.spec());
+	if(!info.is_valid())
+	{ return pixel_store::rgba_image{}; }
+
+	return visit_pixel_type(info.pixel_type, [&input, &info, scaling_factor]<class PixelType>(std::type_identity<PixelType>) {
+		band_reader<PixelType> get_rows{input, scaling_factor};
+		return downsample_to_linear_rgba(
+			get_rows, info.width, info.height, scaling_factor,
+			make_output_layout(info.pixel_ordering, info.width/scaling_factor, info.height/scaling_factor),
+			info.alpha_mode == alpha_mode::straight,
+			get_supported_instruction_set()
+		);
+	});
+}
+
+slideproj::pixel_store::rgba_image
+slideproj::image_file_loader::load_rgba_image(
+	OIIO::ImageInput& input,
+	pixel_store::image_rectangle fit,
+	utils::thread_pool& workers,
+	utils::work_priority_source priority,
+	std::stop_token const& stop_token
+)
+{ return load_fitted_image<pixel_store::rgba_pixel>(input, fit, workers, priority, stop_token); }
+
+slideproj::pixel_store::packed_rgba_image
+slideproj::image_file_loader::load_packed_rgba_image(
+	OIIO::ImageInput& input,
+	pixel_store::image_rectangle fit,
+	utils::thread_pool& workers,
+	utils::work_priority_source priority,
+	std::stop_token const& stop_token
+)
+{
+	// NOTE: Anything with more than 8 bits per sample may have more precision, or range, than
+	//       RGBA8 can hold
+	if(to_value_type_id(input.spec().format) == sample_value_type_id::uint8)
+	{
+		return pixel_store::packed_rgba_image{
+			load_fitted_image<pixel_store::rgba8_srgb_pixel>(input, fit, workers, priority, stop_token)
+		};
+	}
+	return pixel_store::packed_rgba_image{
+		load_fitted_image<pixel_store::rgba16f_pixel>(input, fit, workers, priority, stop_token)
+	};
+}
@@ -9,16 +9,29 @@
 #ifndef SLIDEPROJ_IMAGE_FILE_LOADER_IMAGE_FILE_LOADER_HPP
 #define SLIDEPROJ_IMAGE_FILE_LOADER_IMAGE_FILE_LOADER_HPP
 
+#include "./image_file_index.hpp"
+#include "./downsample.hpp"
+
 #include "src/utils/variant.hpp"
 #include "src/utils/numconv.hpp"
+#include "src/utils/transparent_string_hash.hpp"
+#include "src/utils/thread_pool.hpp"
+#include "src/utils/mapped_file.hpp"
+#include "src/utils/operation_cancelled.hpp"
 #include "src/file_collector/file_collector.hpp"
+#include "src/file_collector/file_metadata_table.hpp"
 #include "src/pixel_store/rgba_image.hpp"
+#include "src/pixel_store/packed_rgba_image.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <stop_token>
 #include <unordered_map>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/filesystem.h>
 #include <Imath/half.h>
 
 namespace slideproj::image_file_loader
@@ -57,6 +70,8 @@ namespace slideproj::image_file_loader
 
 		explicit exif_query_result(OIIO::ImageSpec const& spec);
 
+		explicit exif_query_result(image_file_index_entry const& index_entry);
+
 		// TODO(c++26) Use optional reference
 		std::string const* description() const
 		{ return (m_valid_fields & description_valid)? &m_description : nullptr; }
@@ -74,37 +89,13 @@ namespace slideproj::image_file_loader
 		file_collector::file_clock::time_point m_timestamp{};
 	};
 
-	inline auto load_exif_query_result(std::filesystem::path const& path)
-	{
-		auto img_reader = OIIO::ImageInput::open(path);
-		if(!img_reader)
-		{ return exif_query_result{}; }
-
-		// TODO: Need test image in order to test this
-		return exif_query_result{img_reader->spec()};
-	}
-
-	struct image_file_info:file_collector::file_metadata
-	{
-	};
-
-	image_file_info load_metadata(std::filesystem::path const& path);
-
-	class image_file_metadata_repository
-	{
-	public:
-		image_file_info const& get_metadata(file_collector::file_list_entry const& entry) const;
-
-		static pixel_store::image_rectangle get_dimensions(std::filesystem::path const& path);
-
-	private:
-		mutable std::unordered_map<file_collector::file_id, image_file_info> m_cache;
-	};	static_assert(file_collector::file_metadata_provider<image_file_metadata_repository>);
-
 	template<class Type, class IntensityTransferFunction>
 	requires(std::is_empty_v<IntensityTransferFunction>)
 	struct sample_type
 	{
+		using value_type = Type;
+		using intensity_transfer_function = IntensityTransferFunction;
+
 		Type value;
 		constexpr float to_linear_float() const
 		{ return IntensityTransferFunction::to_linear_float(value); }
@@ -115,10 +106,10 @@ namespace slideproj::image_file_loader
 
 	template<size_t ChannelCount, class IntensityTransferFunction>
 	using pixel_buffer_varying_sample_size = std::variant<
-		std::unique_ptr<pixel_store::pixel_type<sample_type<uint8_t, IntensityTransferFunction>, ChannelCount>[]>,
-		std::unique_ptr<pixel_store::pixel_type<sample_type<uint16_t, IntensityTransferFunction>, ChannelCount>[]>,
-		std::unique_ptr<pixel_store::pixel_type<sample_type<Imath::half, IntensityTransferFunction>, ChannelCount>[]>,
-		std::unique_ptr<pixel_store::pixel_type<sample_type<float, IntensityTransferFunction>, ChannelCount>[]>
+		pixel_store::pooled_pixel_buffer<pixel_store::pixel_type<sample_type<uint8_t, IntensityTransferFunction>, ChannelCount>>,
+		pixel_store::pooled_pixel_buffer<pixel_store::pixel_type<sample_type<uint16_t, IntensityTransferFunction>, ChannelCount>>,
+		pixel_store::pooled_pixel_buffer<pixel_store::pixel_type<sample_type<Imath::half, IntensityTransferFunction>, ChannelCount>>,
+		pixel_store::pooled_pixel_buffer<pixel_store::pixel_type<sample_type<float, IntensityTransferFunction>, ChannelCount>>
 	>;
 
 	template<class IntensityTransferFunction>
@@ -228,6 +219,37 @@ namespace slideproj::image_file_loader
 	constexpr auto is_transposed(pixel_ordering value)
 	{ return static_cast<int>(value) >= 4; }
 
+	// Maps the downsampled w x h image to the output image, as it should appear after applying
+	// value
+	constexpr output_layout make_output_layout(pixel_ordering value, uint32_t w, uint32_t h)
+	{
+		auto const w_s = static_cast<ptrdiff_t>(w);
+		auto const h_s = static_cast<ptrdiff_t>(h);
+		auto const size = is_transposed(value)?
+			pixel_store::image_rectangle{.width = h, .height = w}:
+			pixel_store::image_rectangle{.width = w, .height = h};
+
+		switch(value)
+		{
+			case pixel_ordering::top_to_bottom_right_to_left:
+				return output_layout{size, w_s - 1, -1, w_s};
+			case pixel_ordering::bottom_to_top_right_to_left:
+				return output_layout{size, (w_s - 1) + (h_s - 1)*w_s, -1, -w_s};
+			case pixel_ordering::bottom_to_top_left_to_right:
+				return output_layout{size, (h_s - 1)*w_s, 1, -w_s};
+			case pixel_ordering::left_to_right_top_to_bottom:
+				return output_layout{size, 0, h_s, 1};
+			case pixel_ordering::right_to_left_top_to_bottom:
+				return output_layout{size, h_s - 1, h_s, -1};
+			case pixel_ordering::right_to_left_bottom_to_top:
+				return output_layout{size, (h_s - 1) + (w_s - 1)*h_s, -h_s, -1};
+			case pixel_ordering::left_to_right_bottom_to_top:
+				return output_layout{size, (w_s - 1)*h_s, -h_s, 1};
+			default:
+				return output_layout{size, 0, 1, w_s};
+		}
+	}
+
 	constexpr auto to_pixel_ordering_from_exif_orientation(int value)
 	{
 		if(value < 0 || value > 8)
@@ -237,6 +259,74 @@ namespace slideproj::image_file_loader
 		return static_cast<pixel_ordering>(value - 1);
 	}
 
+	struct image_file_header
+	{
+		pixel_store::image_rectangle dimensions{};
+		size_t channel_count{0};
+		sample_value_type_id sample_type{sample_value_type_id::invalid};
+		int orientation{0};
+		exif_query_result exif;
+		file_collector::file_clock::time_point fs_timestamp{};
+	};
+
+	image_file_header make_image_file_header(OIIO::ImageSpec const& spec);
+
+	// NOTE: Everything needed to select and sort an image is read from a single open of the file.
+	//       fs_timestamp is only set if the file lacks an EXIF timestamp.
+	image_file_header probe_image_file(std::filesystem::path const& path);
+
+	struct image_file_info
+	{
+		file_collector::file_clock::time_point timestamp;
+		std::string in_group;
+		std::string caption;
+	};
+
+	image_file_info make_image_file_info(
+		std::filesystem::path const& path,
+		exif_query_result const& exif_info,
+		file_collector::file_clock::time_point fs_timestamp
+	);
+
+	inline auto make_image_file_info(std::filesystem::path const& path, image_file_header const& header)
+	{ return make_image_file_info(path, header.exif, header.fs_timestamp); }
+
+	inline auto load_metadata(std::filesystem::path const& path)
+	{ return make_image_file_info(path, probe_image_file(path)); }
+
+	class image_file_metadata_repository
+	{
+	public:
+		image_file_metadata_repository() = default;
+
+		// NOTE: If an index is used, it must outlive the repository
+		explicit image_file_metadata_repository(image_file_index& index):
+			m_index{&index}
+		{}
+
+		// NOTE: All query functions may be called concurrently
+		file_collector::file_metadata get_metadata(file_collector::file_list_entry const& entry) const;
+
+		pixel_store::image_rectangle get_dimensions(std::filesystem::path const& path) const
+		{ return get_header(path).dimensions; }
+
+		// NOTE: Headers are memoized by path, since file ids do not exist until the file list has been
+		//       collected. get_metadata moves the header over to the metadata table, keyed by file id.
+		image_file_header get_header(std::filesystem::path const& path) const;
+
+		// Releases the memoized header of a file that will not be part of the file list
+		void discard_header(std::filesystem::path const& path) const;
+
+	private:
+		image_file_header probe(std::filesystem::path const& path) const;
+
+		image_file_index* m_index{nullptr};
+		mutable std::mutex m_headers_mutex;
+		mutable utils::string_lookup_table<image_file_header> m_headers;
+		mutable std::mutex m_metadata_mutex;
+		mutable file_collector::file_metadata_table m_metadata;
+	};	static_assert(file_collector::file_metadata_provider<image_file_metadata_repository>);
+
 	class loaded_image
 	{
 	public:
@@ -295,7 +385,7 @@ namespace slideproj::image_file_loader
 		template<class PixelType>
 		PixelType const* pixels() const
 		{
-			auto item = std::get_if<std::unique_ptr<PixelType[]>>(&m_pixels);
+			auto item = std::get_if<pixel_store::pooled_pixel_buffer<PixelType>>(&m_pixels);
 			if(item == nullptr)
 			{ return nullptr; }
 			return item->get();
@@ -311,19 +401,41 @@ namespace slideproj::image_file_loader
 
 	loaded_image load_image(OIIO::ImageInput& input);
 
-	inline auto open_image_file(std::filesystem::path const& path)
+	// An image file whose contents are held in memory. The decoder reads through an IOProxy, instead
+	// of issuing a system call for every small read, and the header probe and the pixel decode use
+	// the same bytes.
+	//
+	// NOTE: Formats that cannot be read through an IOProxy are opened by path
+	class image_file
 	{
-		OIIO::ImageSpec spec_in;
-		spec_in.attribute("oiio:UnassociatedAlpha", 1);
-		return OIIO::ImageInput::open(path, &spec_in);
-	}
+	public:
+		image_file() = default;
+
+		explicit image_file(std::filesystem::path const& path, utils::mapped_file_mode mode);
+
+		OIIO::ImageInput* input() const
+		{ return m_input.get(); }
+
+		// The time spent reading the file, before any decoding took place
+		auto read_time() const
+		{ return m_read_time; }
+
+	private:
+		utils::mapped_file m_data;
+		std::unique_ptr<OIIO::Filesystem::IOMemReader> m_io_proxy;
+		std::unique_ptr<OIIO::ImageInput> m_input;
+		std::chrono::steady_clock::duration m_read_time{};
+	};
+
+	inline auto open_image_file(std::filesystem::path const& path)
+	{ return image_file{path, utils::mapped_file_mode::preload}; }
 
 	inline auto load_image(std::filesystem::path const& path)
 	{
-		auto img_reader = open_image_file(path);
-		if(img_reader == nullptr)
+		auto const file = open_image_file(path);
+		if(file.input() == nullptr)
 		{ return loaded_image{}; }
-		return load_image(*img_reader);
+		return load_image(*file.input());
 	}
 
 	template<class PixelType>
@@ -532,31 +644,102 @@ namespace slideproj::image_file_loader
 	pixel_store::rgba_image
 	make_linear_rgba_image(loaded_image const& input, uint32_t scaling_factor);
 
-	inline auto load_rgba_image(OIIO::ImageInput& input, uint32_t scaling_factor)
-	{ return make_linear_rgba_image(load_image(input), scaling_factor); }
+	// NOTE: The image is decoded in bands, which are downsampled as they arrive. Thus, the full
+	//       resolution image is never held in memory.
+	pixel_store::rgba_image load_rgba_image(OIIO::ImageInput& input, uint32_t scaling_factor);
 
 	inline auto load_rgba_image(std::filesystem::path const& path, uint32_t scaling_factor)
 	{
-		auto img_reader = open_image_file(path);
-		if(img_reader == nullptr)
+		auto const file = open_image_file(path);
+		if(file.input() == nullptr)
 		{ return pixel_store::rgba_image{}; }
-		return load_rgba_image(*img_reader, scaling_factor);
+		return load_rgba_image(*file.input(), scaling_factor);
 	}
 
 	uint32_t compute_scaling_factor(pixel_store::image_rectangle input, pixel_store::image_rectangle fit);
 
-	pixel_store::rgba_image
-	make_linear_rgba_image(loaded_image const& input, pixel_store::image_rectangle fit);
+	// Returns the largest size with the aspect ratio of input that fits within fit. Images are
+	// never upscaled.
+	pixel_store::image_rectangle
+	compute_fitted_size(pixel_store::image_rectangle input, pixel_store::image_rectangle fit);
+
+	// NOTE: Rows are processed by workers, with the given priority. The calling thread takes part in
+	//       the work.
+	pixel_store::rgba_image make_linear_rgba_image(
+		loaded_image const& input,
+		pixel_store::image_rectangle fit,
+		utils::thread_pool& workers,
+		utils::work_priority_source priority
+	);
+
+	// NOTE: Decoding stops with utils::operation_cancelled, when a stop is requested through
+	//       stop_token
+	pixel_store::rgba_image load_rgba_image(
+		OIIO::ImageInput& input,
+		pixel_store::image_rectangle fit,
+		utils::thread_pool& workers,
+		utils::work_priority_source priority,
+		std::stop_token const& stop_token = std::stop_token{}
+	);
+
+	inline auto load_rgba_image(
+		std::filesystem::path const& path,
+		pixel_store::image_rectangle fit,
+		utils::thread_pool& workers,
+		utils::work_priority_source priority
+	)
+	{
+		auto const file = open_image_file(path);
+		if(file.input() == nullptr)
+		{ return pixel_store::rgba_image{}; }
+		return load_rgba_image(*file.input(), fit, workers, priority);
+	}
 
-	inline auto load_rgba_image(OIIO::ImageInput& input, pixel_store::image_rectangle fit)
-	{ return make_linear_rgba_image(load_image(input), fit); }
+	// Same as load_rgba_image, but the result is stored in a compact format, that can be uploaded
+	// to a texture as is
+	pixel_store::packed_rgba_image load_packed_rgba_image(
+		OIIO::ImageInput& input,
+		pixel_store::image_rectangle fit,
+		utils::thread_pool& workers,
+		utils::work_priority_source priority,
+		std::stop_token const& stop_token = std::stop_token{}
+	);
+
+	struct image_load_timings
+	{
+		std::chrono::steady_clock::duration read_time{};
+		std::chrono::steady_clock::duration decode_time{};
+	};
 
-	inline auto load_rgba_image(std::filesystem::path const& path, pixel_store::image_rectangle fit)
+	inline auto load_packed_rgba_image(
+		std::filesystem::path const& path,
+		pixel_store::image_rectangle fit,
+		utils::thread_pool& workers,
+		utils::work_priority_source priority,
+		image_load_timings& timings,
+		std::stop_token const& stop_token = std::stop_token{}
+	)
 	{
-		auto img_reader = open_image_file(path);
-		if(img_reader == nullptr)
-		{ return pixel_store::rgba_image{}; }
-		return load_rgba_image(*img_reader, fit);
+		auto const file = open_image_file(path);
+		timings.read_time = file.read_time();
+		if(file.input() == nullptr)
+		{ return pixel_store::packed_rgba_image{}; }
+
+		auto const decode_start = std::chrono::steady_clock::now();
+		auto ret = load_packed_rgba_image(*file.input(), fit, workers, priority, stop_token);
+		timings.decode_time = std::chrono::steady_clock::now() - decode_start;
+		return ret;
+	}
+
+	inline auto load_packed_rgba_image(
+		std::filesystem::path const& path,
+		pixel_store::image_rectangle fit,
+		utils::thread_pool& workers,
+		utils::work_priority_source priority
+	)
+	{
+		image_load_timings timings;
+		return load_packed_rgba_image(path, fit, workers, priority, timings);
 	}
 };
 
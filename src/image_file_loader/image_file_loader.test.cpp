@@ -242,13 +242,29 @@ TESTCASE(slideproj_image_file_loader_exif_query_result_from_oiio_sepc_with_orien
 	EXPECT_EQ(result.timestamp(), nullptr);
 }
 
+TESTCASE(slideproj_image_file_loader_make_image_file_header)
+{
+	OIIO::ImageSpec spec{3000, 2000, 3, OIIO::TypeDesc::UINT16};
+	spec.attribute("Orientation", 6);
+	spec.attribute("ImageDescription", "This is a test");
+	auto const res = slideproj::image_file_loader::make_image_file_header(spec);
+	EXPECT_EQ(res.dimensions.width, 3000);
+	EXPECT_EQ(res.dimensions.height, 2000);
+	EXPECT_EQ(res.channel_count, 3);
+	EXPECT_EQ(res.sample_type, slideproj::image_file_loader::sample_value_type_id::uint16);
+	EXPECT_EQ(res.orientation, 6);
+	REQUIRE_NE(res.exif.description(), nullptr);
+	EXPECT_EQ(*res.exif.description(), "This is a test");
+	EXPECT_EQ(res.exif.timestamp(), nullptr);
+}
+
 TESTCASE(slideproj_image_file_get_metadata)
 {
 	slideproj::image_file_loader::image_file_metadata_repository repo;
 	auto const& res = repo.get_metadata(
 		slideproj::file_collector::file_list_entry{
 			slideproj::file_collector::file_id{0},
-			std::filesystem::path{"testdata/IMG_1109.JPG"}
+			"testdata/IMG_1109.JPG"
 		}
 	);
 
@@ -275,15 +291,45 @@ TESTCASE(slideproj_image_file_loader_load_rotated_jpeg_to_rgba_image)
 
 TESTCASE(slideproj_image_file_loader_load_rotated_jpeg_to_rgba_image_fit_rect)
 {
+	slideproj::utils::thread_pool workers{3};
 	auto res = slideproj::image_file_loader::load_rgba_image(
 		"testdata/IMG_1109.JPG",
 		slideproj::pixel_store::image_rectangle{
 			.width = 1920,
 			.height = 1080
-		}
+		},
+		workers,
+		slideproj::utils::work_priority::foreground
 	);
-	EXPECT_EQ(res.width(), 800);
-	EXPECT_EQ(res.height(), 1200);
+	EXPECT_EQ(res.width(), 720);
+	EXPECT_EQ(res.height(), 1080);
+}
+
+TESTCASE(slideproj_image_file_loader_load_rgba_image_fit_rect_cancelled)
+{
+	slideproj::utils::thread_pool workers{3};
+	auto const file = slideproj::image_file_loader::open_image_file("testdata/rgba_8bit_srgb.png");
+	REQUIRE_NE(file.input(), nullptr);
+
+	std::stop_source stop_source;
+	stop_source.request_stop();
+	auto cancelled = false;
+	try
+	{
+		slideproj::image_file_loader::load_rgba_image(
+			*file.input(),
+			slideproj::pixel_store::image_rectangle{
+				.width = 48,
+				.height = 16
+			},
+			workers,
+			slideproj::utils::work_priority::foreground,
+			stop_source.get_token()
+		);
+	}
+	catch(slideproj::utils::operation_cancelled const&)
+	{ cancelled = true; }
+	EXPECT_EQ(cancelled, true);
 }
 
 TESTCASE(slideproj_image_file_loader_load_uint8_rgba_from_png_srbg)
@@ -410,4 +456,22 @@ TESTCASE(slideproj_image_file_loader_load_rgba_image_from_png_srbg)
 	EXPECT_EQ(pixels[64].green, 0.0f);
 	EXPECT_EQ(pixels[64].blue, 0.108353525f);
 	EXPECT_EQ(pixels[64].alpha, 0.50196081f);
-}
\ No newline at end of file
+}
+TESTCASE(slideproj_image_file_loader_compute_fitted_size)
+{
+	using slideproj::pixel_store::image_rectangle;
+	using slideproj::image_file_loader::compute_fitted_size;
+	image_rectangle const fit{.width = 3200, .height = 1800};
+
+	auto const landscape = compute_fitted_size(image_rectangle{.width = 6000, .height = 4000}, fit);
+	EXPECT_EQ(landscape.width, 2700);
+	EXPECT_EQ(landscape.height, 1800);
+
+	auto const panorama = compute_fitted_size(image_rectangle{.width = 6000, .height = 2000}, fit);
+	EXPECT_EQ(panorama.width, 3200);
+	EXPECT_EQ(panorama.height, 1067);
+
+	auto const small = compute_fitted_size(image_rectangle{.width = 640, .height = 480}, fit);
+	EXPECT_EQ(small.width, 640);
+	EXPECT_EQ(small.height, 480);
+}
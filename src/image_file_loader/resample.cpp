@@ -0,0 +1,228 @@
+//@	{"target": {"name":"resample.o"}}
+
+#include "./resample.hpp"
+
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+namespace
+{
+	constexpr float lanczos3(float x)
+	{
+		if(x == 0.0f)
+		{ return 1.0f; }
+
+		if(std::abs(x) >= 3.0f)
+		{ return 0.0f; }
+
+		auto const pi_x = std::numbers::pi_v<float>*x;
+		return 3.0f*std::sin(pi_x)*std::sin(pi_x/3.0f)/(pi_x*pi_x);
+	}
+
+	// NOTE: Each work item covers a few rows, so threads do not contend on the item counter
+	constexpr uint32_t rows_per_item = 8;
+
+	template<class Callable>
+	void for_each_row(
+		uint32_t row_count,
+		slideproj::utils::thread_pool& workers,
+		slideproj::utils::work_priority_source priority,
+		Callable&& func
+	)
+	{
+		workers.parallel_for(
+			(row_count + rows_per_item - 1)/rows_per_item,
+			priority,
+			[row_count, &func](size_t item) {
+				auto const begin = static_cast<uint32_t>(item)*rows_per_item;
+				auto const end = std::min(begin + rows_per_item, row_count);
+				for(auto y = begin; y != end; ++y)
+				{ func(y); }
+			}
+		);
+	}
+}
+
+slideproj::image_file_loader::resampling_weights
+slideproj::image_file_loader::make_lanczos3_weights(uint32_t input_size, uint32_t output_size)
+{
+	auto const scale = static_cast<float>(input_size)/static_cast<float>(output_size);
+	// NOTE: When downsampling, the filter is stretched so it also removes frequencies that the
+	//       output cannot represent
+	auto const filter_scale = std::max(scale, 1.0f);
+	auto const support = 3.0f*filter_scale;
+	auto const taps_per_sample = std::min(
+		static_cast<size_t>(std::ceil(2.0f*support)) + 1,
+		static_cast<size_t>(input_size)
+	);
+
+	resampling_weights ret{
+		.taps_per_sample = taps_per_sample,
+		.first_input = std::vector<uint32_t>(output_size),
+		.weights = std::vector<float>(output_size*taps_per_sample)
+	};
+
+	auto const last_first = static_cast<ptrdiff_t>(input_size - taps_per_sample);
+	for(uint32_t k = 0; k != output_size; ++k)
+	{
+		auto const center = (static_cast<float>(k) + 0.5f)*scale - 0.5f;
+		auto const first = std::clamp(
+			static_cast<ptrdiff_t>(std::ceil(center - support)),
+			static_cast<ptrdiff_t>(0),
+			last_first
+		);
+		ret.first_input[k] = static_cast<uint32_t>(first);
+
+		auto const weights = std::data(ret.weights) + k*taps_per_sample;
+		auto sum = 0.0f;
+		for(size_t i = 0; i != taps_per_sample; ++i)
+		{
+			auto const x = static_cast<float>(first + static_cast<ptrdiff_t>(i)) - center;
+			weights[i] = lanczos3(x/filter_scale);
+			sum += weights[i];
+		}
+
+		// NOTE: Taps outside the image are dropped, so weights are normalized to preserve
+		//       brightness at the edges
+		for(size_t i = 0; i != taps_per_sample; ++i)
+		{ weights[i] /= sum; }
+	}
+
+	return ret;
+}
+
+slideproj::image_file_loader::streaming_resampler::streaming_resampler(
+	pixel_store::image_rectangle input_size,
+	pixel_store::image_rectangle output_size,
+	utils::thread_pool& workers,
+	utils::work_priority_source priority
+):
+	m_input_size{input_size},
+	m_workers{workers},
+	m_priority{priority},
+	m_horizontal_weights{make_lanczos3_weights(input_size.width, output_size.width)},
+	m_vertical_weights{make_lanczos3_weights(input_size.height, output_size.height)},
+	m_window_begin{0},
+	m_rows_received{0},
+	m_next_output_row{0},
+	m_output{output_size.width, output_size.height, pixel_store::make_uninitialized_pixel_buffer_tag{}}
+{}
+
+void slideproj::image_file_loader::streaming_resampler::push_rows(
+	pixel_store::rgba_pixel const* rows,
+	uint32_t row_count
+)
+{
+	auto const w_in = m_input_size.width;
+	auto const w_out = m_output.width();
+	auto const h_out = m_output.height();
+
+	auto const window_rows_in = std::size(m_window)/w_out;
+	m_window.resize(std::size(m_window) + static_cast<size_t>(row_count)*w_out);
+	for_each_row(
+		row_count,
+		m_workers,
+		m_priority,
+		[&weights = m_horizontal_weights, rows, w_in, w_out, rows_out = std::data(m_window) + window_rows_in*w_out](
+			uint32_t y
+		) {
+			auto const row_in = rows + static_cast<size_t>(y)*w_in;
+			auto const row_out = rows_out + static_cast<size_t>(y)*w_out;
+			for(uint32_t x = 0; x != w_out; ++x)
+			{
+				auto const taps = row_in + weights.first_input[x];
+				auto const w = std::data(weights.weights) + x*weights.taps_per_sample;
+				pixel_store::rgba_pixel sum{};
+				for(size_t i = 0; i != weights.taps_per_sample; ++i)
+				{
+					sum.red += w[i]*taps[i].red;
+					sum.green += w[i]*taps[i].green;
+					sum.blue += w[i]*taps[i].blue;
+					sum.alpha += w[i]*taps[i].alpha;
+				}
+				row_out[x] = sum;
+			}
+		}
+	);
+	m_rows_received += row_count;
+
+	auto const& weights = m_vertical_weights;
+	auto output_end = m_next_output_row;
+	while(output_end != h_out && weights.first_input[output_end] + weights.taps_per_sample <= m_rows_received)
+	{ ++output_end; }
+
+	for_each_row(
+		output_end - m_next_output_row,
+		m_workers,
+		m_priority,
+		[
+			&weights,
+			y_begin = m_next_output_row,
+			window = std::data(m_window),
+			window_begin = m_window_begin,
+			output = m_output.pixels(),
+			w_out
+		](uint32_t k) {
+			auto const y = y_begin + k;
+			auto const row_out = output + static_cast<size_t>(y)*w_out;
+			auto const w = std::data(weights.weights) + y*weights.taps_per_sample;
+			std::fill_n(row_out, w_out, pixel_store::rgba_pixel{});
+			for(size_t i = 0; i != weights.taps_per_sample; ++i)
+			{
+				auto const row_in = window + (weights.first_input[y] - window_begin + i)*w_out;
+				for(uint32_t x = 0; x != w_out; ++x)
+				{
+					row_out[x].red += w[i]*row_in[x].red;
+					row_out[x].green += w[i]*row_in[x].green;
+					row_out[x].blue += w[i]*row_in[x].blue;
+					row_out[x].alpha += w[i]*row_in[x].alpha;
+				}
+			}
+
+			for(uint32_t x = 0; x != w_out; ++x)
+			{
+				auto& item = row_out[x];
+				item.alpha = std::clamp(item.alpha, 0.0f, 1.0f);
+				item.red = std::max(item.red, 0.0f);
+				item.green = std::max(item.green, 0.0f);
+				item.blue = std::max(item.blue, 0.0f);
+			}
+		}
+	);
+	m_next_output_row = output_end;
+
+	// NOTE: first_input is non-decreasing, so rows before the first tap of the next output row
+	//       will not be used again
+	auto const new_window_begin = m_next_output_row != h_out?
+		weights.first_input[m_next_output_row]:
+		m_rows_received;
+	auto const rows_to_drop = std::min(new_window_begin, m_rows_received) - m_window_begin;
+	m_window.erase(std::begin(m_window), std::begin(m_window) + static_cast<ptrdiff_t>(rows_to_drop*w_out));
+	m_window_begin += rows_to_drop;
+}
+
+slideproj::pixel_store::rgba_image slideproj::image_file_loader::streaming_resampler::take_result() &&
+{ return std::move(m_output); }
+
+slideproj::pixel_store::rgba_image slideproj::image_file_loader::resample(
+	pixel_store::rgba_image const& src,
+	pixel_store::image_rectangle output_size,
+	utils::thread_pool& workers,
+	utils::work_priority_source priority
+)
+{
+	if(src.is_empty() || output_size.width == 0 || output_size.height == 0)
+	{ return pixel_store::rgba_image{}; }
+
+	streaming_resampler resampler{
+		pixel_store::image_rectangle{.width = src.width(), .height = src.height()},
+		output_size,
+		workers,
+		priority
+	};
+	resampler.push_rows(src.pixels(), src.height());
+	return std::move(resampler).take_result();
+}
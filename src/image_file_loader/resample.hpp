@@ -0,0 +1,74 @@
+//@	{"dependencies_extra":[{"ref":"./resample.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_IMAGE_FILE_LOADER_RESAMPLE_HPP
+#define SLIDEPROJ_IMAGE_FILE_LOADER_RESAMPLE_HPP
+
+#include "src/pixel_store/basic_image.hpp"
+#include "src/pixel_store/rgba_image.hpp"
+#include "src/utils/thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace slideproj::image_file_loader
+{
+	// Filter weights for mapping input_size samples to output_size samples along one axis. Output
+	// sample k is the sum of weights[k*taps_per_sample + i]*input[first_input[k] + i].
+	struct resampling_weights
+	{
+		size_t taps_per_sample;
+		std::vector<uint32_t> first_input;
+		std::vector<float> weights;
+	};
+
+	resampling_weights make_lanczos3_weights(uint32_t input_size, uint32_t output_size);
+
+	// Resamples an image that arrives a few rows at a time, using a separable Lanczos-3 filter.
+	// Only the rows still needed by the vertical filter are kept. Rows are distributed over workers,
+	// with the given priority.
+	//
+	// NOTE: Input should be in linear light, with premultiplied alpha. Negative values caused by
+	//       ringing are clamped away.
+	class streaming_resampler
+	{
+	public:
+		explicit streaming_resampler(
+			pixel_store::image_rectangle input_size,
+			pixel_store::image_rectangle output_size,
+			utils::thread_pool& workers,
+			utils::work_priority_source priority
+		);
+
+		// Adds row_count consecutive input rows
+		void push_rows(pixel_store::rgba_pixel const* rows, uint32_t row_count);
+
+		// NOTE: All input rows must have been pushed
+		pixel_store::rgba_image take_result() &&;
+
+	private:
+		pixel_store::image_rectangle m_input_size;
+		std::reference_wrapper<utils::thread_pool> m_workers;
+		utils::work_priority_source m_priority;
+		resampling_weights m_horizontal_weights;
+		resampling_weights m_vertical_weights;
+
+		// NOTE: Horizontally resampled rows, starting at input row m_window_begin
+		std::vector<pixel_store::rgba_pixel> m_window;
+		uint32_t m_window_begin;
+		uint32_t m_rows_received;
+		uint32_t m_next_output_row;
+		pixel_store::rgba_image m_output;
+	};
+
+	// Resamples src to output_size in one go
+	pixel_store::rgba_image resample(
+		pixel_store::rgba_image const& src,
+		pixel_store::image_rectangle output_size,
+		utils::thread_pool& workers,
+		utils::work_priority_source priority
+	);
+}
+
+#endif
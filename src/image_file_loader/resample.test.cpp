@@ -0,0 +1,171 @@
+//@	{"target":{"name":"resample.test"}}
+
+#include "./resample.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+TESTCASE(slideproj_image_file_loader_make_lanczos3_weights_downsample)
+{
+	auto const res = slideproj::image_file_loader::make_lanczos3_weights(100, 37);
+	EXPECT_EQ(std::size(res.first_input), 37);
+	EXPECT_EQ(std::size(res.weights), 37*res.taps_per_sample);
+
+	for(size_t k = 0; k != std::size(res.first_input); ++k)
+	{
+		EXPECT_LE(res.first_input[k] + res.taps_per_sample, 100);
+		auto const weights = std::data(res.weights) + k*res.taps_per_sample;
+		auto const sum = std::accumulate(weights, weights + res.taps_per_sample, 0.0f);
+		EXPECT_LT(std::abs(sum - 1.0f), 1.0e-5f);
+	}
+}
+
+TESTCASE(slideproj_image_file_loader_make_lanczos3_weights_small_input)
+{
+	auto const res = slideproj::image_file_loader::make_lanczos3_weights(3, 2);
+	EXPECT_EQ(res.taps_per_sample, 3);
+	EXPECT_EQ(res.first_input[0], 0);
+	EXPECT_EQ(res.first_input[1], 0);
+}
+
+TESTCASE(slideproj_image_file_loader_resample_constant_image)
+{
+	slideproj::utils::thread_pool workers{3};
+	slideproj::pixel_store::rgba_image src{
+		123, 77, slideproj::pixel_store::make_uninitialized_pixel_buffer_tag{}
+	};
+	std::fill_n(
+		src.pixels(),
+		src.pixel_count(),
+		slideproj::pixel_store::rgba_pixel{.red = 0.25f, .green = 0.5f, .blue = 0.125f, .alpha = 0.75f}
+	);
+
+	auto const res = slideproj::image_file_loader::resample(
+		src,
+		slideproj::pixel_store::image_rectangle{.width = 50, .height = 31},
+		workers,
+		slideproj::utils::work_priority::foreground
+	);
+	REQUIRE_EQ(res.width(), 50);
+	REQUIRE_EQ(res.height(), 31);
+
+	auto max_error = 0.0f;
+	for(size_t k = 0; k != res.pixel_count(); ++k)
+	{
+		auto const item = res.pixels()[k];
+		max_error = std::max(max_error, std::abs(item.red - 0.25f));
+		max_error = std::max(max_error, std::abs(item.green - 0.5f));
+		max_error = std::max(max_error, std::abs(item.blue - 0.125f));
+		max_error = std::max(max_error, std::abs(item.alpha - 0.75f));
+	}
+	EXPECT_LT(max_error, 1.0e-5f);
+}
+
+TESTCASE(slideproj_image_file_loader_resample_clamps_ringing)
+{
+	slideproj::utils::thread_pool workers{3};
+	slideproj::pixel_store::rgba_image src{
+		64, 64, slideproj::pixel_store::make_uninitialized_pixel_buffer_tag{}
+	};
+	for(uint32_t y = 0; y != src.height(); ++y)
+	{
+		for(uint32_t x = 0; x != src.width(); ++x)
+		{
+			auto const value = (x/4 + y/4)%2 == 0? 1.0f : 0.0f;
+			src(x, y) = slideproj::pixel_store::rgba_pixel{
+				.red = value,
+				.green = value,
+				.blue = value,
+				.alpha = value
+			};
+		}
+	}
+
+	auto const res = slideproj::image_file_loader::resample(
+		src,
+		slideproj::pixel_store::image_rectangle{.width = 23, .height = 23},
+		workers,
+		slideproj::utils::work_priority::foreground
+	);
+	REQUIRE_EQ(res.width(), 23);
+	REQUIRE_EQ(res.height(), 23);
+	for(size_t k = 0; k != res.pixel_count(); ++k)
+	{
+		auto const item = res.pixels()[k];
+		EXPECT_GE(item.red, 0.0f);
+		EXPECT_GE(item.alpha, 0.0f);
+		EXPECT_LE(item.alpha, 1.0f);
+	}
+}
+
+TESTCASE(slideproj_image_file_loader_resample_empty)
+{
+	slideproj::utils::thread_pool workers{3};
+	auto const res = slideproj::image_file_loader::resample(
+		slideproj::pixel_store::rgba_image{},
+		slideproj::pixel_store::image_rectangle{.width = 10, .height = 10},
+		workers,
+		slideproj::utils::work_priority::foreground
+	);
+	EXPECT_EQ(res.is_empty(), true);
+}
+
+TESTCASE(slideproj_image_file_loader_streaming_resampler_same_as_resample)
+{
+	slideproj::pixel_store::rgba_image src{
+		97, 101, slideproj::pixel_store::make_uninitialized_pixel_buffer_tag{}
+	};
+	for(uint32_t y = 0; y != src.height(); ++y)
+	{
+		for(uint32_t x = 0; x != src.width(); ++x)
+		{
+			auto const value = static_cast<float>((x*7 + y*13)%17)/16.0f;
+			src(x, y) = slideproj::pixel_store::rgba_pixel{
+				.red = value,
+				.green = 1.0f - value,
+				.blue = 0.5f*value,
+				.alpha = 1.0f
+			};
+		}
+	}
+
+	slideproj::pixel_store::image_rectangle const output_size{.width = 40, .height = 53};
+	slideproj::utils::thread_pool no_workers{0};
+	auto const expected = slideproj::image_file_loader::resample(
+		src,
+		output_size,
+		no_workers,
+		slideproj::utils::work_priority::foreground
+	);
+
+	slideproj::utils::thread_pool workers{2};
+	slideproj::image_file_loader::streaming_resampler resampler{
+		slideproj::pixel_store::image_rectangle{.width = src.width(), .height = src.height()},
+		output_size,
+		workers,
+		slideproj::utils::work_priority::background
+	};
+	uint32_t y = 0;
+	for(uint32_t band_size = 1; y != src.height(); ++band_size)
+	{
+		auto const row_count = std::min(band_size, src.height() - y);
+		resampler.push_rows(src.pixels() + static_cast<size_t>(y)*src.width(), row_count);
+		y += row_count;
+	}
+	auto const res = std::move(resampler).take_result();
+	REQUIRE_EQ(res.width(), expected.width());
+	REQUIRE_EQ(res.height(), expected.height());
+
+	auto max_error = 0.0f;
+	for(size_t k = 0; k != res.pixel_count(); ++k)
+	{
+		max_error = std::max(max_error, std::abs(res.pixels()[k].red - expected.pixels()[k].red));
+		max_error = std::max(max_error, std::abs(res.pixels()[k].green - expected.pixels()[k].green));
+		max_error = std::max(max_error, std::abs(res.pixels()[k].blue - expected.pixels()[k].blue));
+		max_error = std::max(max_error, std::abs(res.pixels()[k].alpha - expected.pixels()[k].alpha));
+	}
+	EXPECT_EQ(max_error, 0.0f);
+}
@@ -1,6 +1,8 @@
 #ifndef SLIDEPROJ_PIXEL_STORE_BASIC_IMAGE_HPP
 #define SLIDEPROJ_PIXEL_STORE_BASIC_IMAGE_HPP
 
+#include "./pixel_buffer_pool.hpp"
+
 #include <memory>
 #include <cstdint>
 #include <cstddef>
@@ -31,7 +33,7 @@ namespace slideproj::pixel_store
 		):
 			m_width{w},
 			m_height{h},
-			m_pixels{std::make_unique_for_overwrite<T[]>(static_cast<size_t>(w)*static_cast<size_t>(h))}
+			m_pixels{make_pooled_pixel_buffer<T>(static_cast<size_t>(w)*static_cast<size_t>(h))}
 		{}
 
 		auto width() const
@@ -61,7 +63,7 @@ namespace slideproj::pixel_store
 	private:
 		uint32_t m_width{0};
 		uint32_t m_height{0};
-		std::unique_ptr<T[]> m_pixels;
+		pooled_pixel_buffer<T> m_pixels;
 	};
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,115 @@
+//@	{"dependencies_extra":[{"ref":"Imath", "rel":"implementation", "origin":"pkg-config"}]}
+
+#ifndef SLIDEPROJ_PIXEL_STORE_PACKED_RGBA_IMAGE_HPP
+#define SLIDEPROJ_PIXEL_STORE_PACKED_RGBA_IMAGE_HPP
+
+#include "./basic_image.hpp"
+#include "./pixel_types.hpp"
+#include "./rgba_image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <variant>
+#include <Imath/half.h>
+
+namespace slideproj::pixel_store
+{
+	// NOTE: Color samples are sRGB encoded after premultiplication, and alpha is linear, as in a
+	//       GL_SRGB8_ALPHA8 texture
+	struct srgb8_sample
+	{
+		uint8_t value;
+	};
+
+	using rgba8_srgb_pixel = pixel_type<srgb8_sample, 4>;
+	using rgba8_srgb_image = basic_image<rgba8_srgb_pixel>;
+
+	using rgba16f_pixel = pixel_type<Imath::half, 4>;
+	using rgba16f_image = basic_image<rgba16f_pixel>;
+
+	inline auto make_linear_to_srgb8_lut()
+	{
+		// NOTE: 16 bits of input are needed to keep dark tones apart
+		auto ret = std::make_unique_for_overwrite<std::array<uint8_t, 65536>>();
+		for(size_t k = 0; k != std::size(*ret); ++k)
+		{
+			auto const val = static_cast<float>(k)/65535.0f;
+			auto const encoded = (val <= 0.0031308f)? 12.92f*val : 1.055f*std::pow(val, 1.0f/2.4f) - 0.055f;
+			(*ret)[k] = static_cast<uint8_t>(std::lround(255.0f*encoded));
+		}
+		return ret;
+	}
+
+	inline uint8_t to_srgb8(float value)
+	{
+		static auto const lut = make_linear_to_srgb8_lut();
+		return (*lut)[static_cast<size_t>(std::lround(65535.0f*std::clamp(value, 0.0f, 1.0f)))];
+	}
+
+	inline uint8_t to_unorm8(float value)
+	{ return static_cast<uint8_t>(std::lround(255.0f*std::clamp(value, 0.0f, 1.0f))); }
+
+	// Converts a linear, premultiplied pixel to PixelType
+	template<class PixelType>
+	PixelType make_pixel_from_linear(rgba_pixel const& value);
+
+	template<>
+	inline rgba_pixel make_pixel_from_linear<rgba_pixel>(rgba_pixel const& value)
+	{ return value; }
+
+	template<>
+	inline rgba8_srgb_pixel make_pixel_from_linear<rgba8_srgb_pixel>(rgba_pixel const& value)
+	{
+		return rgba8_srgb_pixel{
+			.red = srgb8_sample{to_srgb8(value.red)},
+			.green = srgb8_sample{to_srgb8(value.green)},
+			.blue = srgb8_sample{to_srgb8(value.blue)},
+			.alpha = srgb8_sample{to_unorm8(value.alpha)}
+		};
+	}
+
+	template<>
+	inline rgba16f_pixel make_pixel_from_linear<rgba16f_pixel>(rgba_pixel const& value)
+	{
+		return rgba16f_pixel{
+			.red = Imath::half{value.red},
+			.green = Imath::half{value.green},
+			.blue = Imath::half{value.blue},
+			.alpha = Imath::half{value.alpha}
+		};
+	}
+
+	// An RGBA image in the most compact format that suits its source. 8-bit sources become
+	// rgba8_srgb_image, and everything else rgba16f_image.
+	class packed_rgba_image
+	{
+	public:
+		packed_rgba_image() = default;
+
+		template<class PixelType>
+		explicit packed_rgba_image(basic_image<PixelType>&& image):
+			m_image{std::move(image)}
+		{}
+
+		template<class Callable>
+		decltype(auto) visit(Callable&& cb) const
+		{ return std::visit(std::forward<Callable>(cb), m_image); }
+
+		auto width() const
+		{ return visit([](auto const& item){ return item.width(); }); }
+
+		auto height() const
+		{ return visit([](auto const& item){ return item.height(); }); }
+
+		bool is_empty() const
+		{ return visit([](auto const& item){ return item.is_empty(); }); }
+
+	private:
+		std::variant<rgba8_srgb_image, rgba16f_image> m_image;
+	};
+}
+
+#endif
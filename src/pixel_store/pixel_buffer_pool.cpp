@@ -0,0 +1,170 @@
+//@	{"target": {"name":"pixel_buffer_pool.o"}}
+
+#include "./pixel_buffer_pool.hpp"
+
+#include <sys/mman.h>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	constexpr size_t page_size = 4096;
+	constexpr size_t huge_page_size = static_cast<size_t>(2) << 20;
+
+	constexpr size_t round_to_size_class(size_t size)
+	{
+		auto const page_count = (size + page_size - 1)/page_size;
+		if(page_count <= 8)
+		{ return page_count*page_size; }
+
+		auto const step = std::bit_floor(page_count)/4;
+		return step*((page_count + step - 1)/step)*page_size;
+	}
+
+	static_assert(round_to_size_class(1) == page_size);
+	static_assert(round_to_size_class(9*page_size) == 10*page_size);
+	static_assert(round_to_size_class(17*page_size) == 20*page_size);
+
+	void* map_block(size_t size, bool use_huge_pages)
+	{
+		if(!use_huge_pages || size < huge_page_size)
+		{
+			auto const ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(ptr == MAP_FAILED)
+			{ throw std::runtime_error{std::format("Failed to allocate pixel buffer: {}", strerror(errno))}; }
+			return ptr;
+		}
+
+		// NOTE: Map some extra memory so the block can start at a huge page boundary, and give the
+		//       unused head and tail back
+		auto const mapped_size = size + huge_page_size;
+		auto const ptr = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(ptr == MAP_FAILED)
+		{ throw std::runtime_error{std::format("Failed to allocate pixel buffer: {}", strerror(errno))}; }
+
+		auto const mapped_begin = reinterpret_cast<uintptr_t>(ptr);
+		auto const begin = (mapped_begin + huge_page_size - 1) & ~(huge_page_size - 1);
+		auto const head_size = begin - mapped_begin;
+		auto const tail_size = mapped_size - head_size - size;
+		if(head_size != 0)
+		{ ::munmap(ptr, head_size); }
+		if(tail_size != 0)
+		{ ::munmap(reinterpret_cast<void*>(begin + size), tail_size); }
+
+		auto const ret = reinterpret_cast<void*>(begin);
+		// NOTE: This is only a hint. The buffer works without huge pages.
+		::madvise(ret, size, MADV_HUGEPAGE);
+		return ret;
+	}
+}
+
+slideproj::pixel_store::pixel_buffer_pool::~pixel_buffer_pool()
+{ trim(); }
+
+void* slideproj::pixel_store::pixel_buffer_pool::allocate(size_t size)
+{
+	if(size == 0)
+	{ return nullptr; }
+
+	// NOTE: Rounding up to the size class, or to a huge page boundary, must not wrap around
+	if(size > std::numeric_limits<size_t>::max()/4)
+	{ throw std::runtime_error{"Pixel buffer size is too large"}; }
+
+	auto const block_size = round_to_size_class(size);
+	auto use_huge_pages = false;
+	{
+		std::lock_guard lock{m_mutex};
+		auto const i = m_free_blocks.find(block_size);
+		if(i != std::end(m_free_blocks) && !i->second.empty())
+		{
+			auto const ret = i->second.back();
+			i->second.pop_back();
+			m_cached_bytes -= block_size;
+			++m_hits;
+			return ret;
+		}
+		++m_misses;
+		use_huge_pages = m_params.use_huge_pages;
+	}
+
+	auto const ret = map_block(block_size, use_huge_pages);
+	std::lock_guard lock{m_mutex};
+	m_resident_bytes += block_size;
+	return ret;
+}
+
+void slideproj::pixel_store::pixel_buffer_pool::deallocate(void* ptr, size_t size) noexcept
+{
+	if(ptr == nullptr)
+	{ return; }
+
+	auto const block_size = round_to_size_class(size);
+	{
+		std::lock_guard lock{m_mutex};
+		if(m_cached_bytes + block_size <= m_params.max_cached_bytes)
+		{
+			try
+			{
+				m_free_blocks[block_size].push_back(ptr);
+				m_cached_bytes += block_size;
+				return;
+			}
+			catch(...)
+			{}
+		}
+		m_resident_bytes -= block_size;
+	}
+
+	::munmap(ptr, block_size);
+}
+
+void slideproj::pixel_store::pixel_buffer_pool::trim()
+{
+	std::unordered_map<size_t, std::vector<void*>> free_blocks;
+	{
+		std::lock_guard lock{m_mutex};
+		free_blocks = std::move(m_free_blocks);
+		m_free_blocks.clear();
+		m_resident_bytes -= m_cached_bytes;
+		m_cached_bytes = 0;
+	}
+
+	for(auto const& item : free_blocks)
+	{
+		for(auto const ptr : item.second)
+		{ ::munmap(ptr, item.first); }
+	}
+}
+
+void slideproj::pixel_store::pixel_buffer_pool::set_params(pixel_buffer_pool_descriptor const& params)
+{
+	{
+		std::lock_guard lock{m_mutex};
+		m_params = params;
+		if(m_cached_bytes <= m_params.max_cached_bytes)
+		{ return; }
+	}
+	trim();
+}
+
+slideproj::pixel_store::pixel_buffer_pool_stats slideproj::pixel_store::pixel_buffer_pool::stats() const
+{
+	std::lock_guard lock{m_mutex};
+	return pixel_buffer_pool_stats{
+		.hits = m_hits,
+		.misses = m_misses,
+		.resident_bytes = m_resident_bytes,
+		.cached_bytes = m_cached_bytes
+	};
+}
+
+slideproj::pixel_store::pixel_buffer_pool& slideproj::pixel_store::get_default_pixel_buffer_pool()
+{
+	static pixel_buffer_pool ret;
+	return ret;
+}
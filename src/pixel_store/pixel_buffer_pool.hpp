@@ -0,0 +1,111 @@
+//@	{"dependencies_extra":[{"ref":"./pixel_buffer_pool.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_PIXEL_STORE_PIXEL_BUFFER_POOL_HPP
+#define SLIDEPROJ_PIXEL_STORE_PIXEL_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace slideproj::pixel_store
+{
+	struct pixel_buffer_pool_descriptor
+	{
+		size_t max_cached_bytes = static_cast<size_t>(512) << 20;
+		bool use_huge_pages = false;
+	};
+
+	struct pixel_buffer_pool_stats
+	{
+		size_t hits;
+		size_t misses;
+		// NOTE: Includes both buffers in use and buffers kept for reuse
+		size_t resident_bytes;
+		size_t cached_bytes;
+	};
+
+	// Keeps released pixel buffers mapped, so the next image of similar size can reuse them without
+	// going through mmap, munmap, and page faults again. Sizes are rounded up to size classes, four
+	// per power of two, so images that differ slightly in size share buffers.
+	//
+	// NOTE: The pool must outlive all buffers allocated from it
+	class pixel_buffer_pool
+	{
+	public:
+		explicit pixel_buffer_pool(pixel_buffer_pool_descriptor const& params = pixel_buffer_pool_descriptor{}):
+			m_params{params}
+		{}
+
+		pixel_buffer_pool(pixel_buffer_pool const&) = delete;
+		pixel_buffer_pool& operator=(pixel_buffer_pool const&) = delete;
+
+		~pixel_buffer_pool();
+
+		void* allocate(size_t size);
+
+		void deallocate(void* ptr, size_t size) noexcept;
+
+		// Unmaps all buffers kept for reuse
+		void trim();
+
+		void set_params(pixel_buffer_pool_descriptor const& params);
+
+		pixel_buffer_pool_stats stats() const;
+
+	private:
+		mutable std::mutex m_mutex;
+		pixel_buffer_pool_descriptor m_params;
+		std::unordered_map<size_t, std::vector<void*>> m_free_blocks;
+		size_t m_hits{0};
+		size_t m_misses{0};
+		size_t m_resident_bytes{0};
+		size_t m_cached_bytes{0};
+	};
+
+	pixel_buffer_pool& get_default_pixel_buffer_pool();
+
+	class pixel_buffer_deleter
+	{
+	public:
+		pixel_buffer_deleter() = default;
+
+		explicit pixel_buffer_deleter(pixel_buffer_pool& pool, size_t size):
+			m_pool{&pool},
+			m_size{size}
+		{}
+
+		void operator()(void* ptr) const noexcept
+		{
+			if(ptr != nullptr)
+			{ m_pool->deallocate(ptr, m_size); }
+		}
+
+	private:
+		pixel_buffer_pool* m_pool{nullptr};
+		size_t m_size{0};
+	};
+
+	template<class T>
+	using pooled_pixel_buffer = std::unique_ptr<T[], pixel_buffer_deleter>;
+
+	template<class T>
+	requires(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>)
+	pooled_pixel_buffer<T> make_pooled_pixel_buffer(
+		size_t count,
+		pixel_buffer_pool& pool = get_default_pixel_buffer_pool()
+	)
+	{
+		if(count > std::numeric_limits<size_t>::max()/sizeof(T))
+		{ throw std::runtime_error{"Pixel buffer size is too large"}; }
+
+		auto const size = count*sizeof(T);
+		return pooled_pixel_buffer<T>{static_cast<T*>(pool.allocate(size)), pixel_buffer_deleter{pool, size}};
+	}
+}
+
+#endif
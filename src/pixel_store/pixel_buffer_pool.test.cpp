@@ -0,0 +1,118 @@
+//@	{"target":{"name":"pixel_buffer_pool.test"}}
+
+#include "./pixel_buffer_pool.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+TESTCASE(slideproj_pixel_store_pixel_buffer_pool_reuses_released_buffer)
+{
+	slideproj::pixel_store::pixel_buffer_pool pool;
+	void* first_ptr = nullptr;
+	{
+		auto const buffer = slideproj::pixel_store::make_pooled_pixel_buffer<float>(100000, pool);
+		std::fill_n(buffer.get(), 100000, 1.0f);
+		first_ptr = buffer.get();
+	}
+
+	auto const stats_after_release = pool.stats();
+	EXPECT_EQ(stats_after_release.hits, 0);
+	EXPECT_EQ(stats_after_release.misses, 1);
+	EXPECT_EQ(stats_after_release.cached_bytes, stats_after_release.resident_bytes);
+
+	// NOTE: A slightly smaller buffer is in the same size class
+	auto const buffer = slideproj::pixel_store::make_pooled_pixel_buffer<float>(99000, pool);
+	EXPECT_EQ(static_cast<void*>(buffer.get()), first_ptr);
+
+	auto const stats = pool.stats();
+	EXPECT_EQ(stats.hits, 1);
+	EXPECT_EQ(stats.misses, 1);
+	EXPECT_EQ(stats.cached_bytes, 0);
+	EXPECT_EQ(stats.resident_bytes, stats_after_release.resident_bytes);
+}
+
+TESTCASE(slideproj_pixel_store_pixel_buffer_pool_different_size_classes)
+{
+	slideproj::pixel_store::pixel_buffer_pool pool;
+	{
+		auto const buffer = slideproj::pixel_store::make_pooled_pixel_buffer<uint8_t>(1 << 20, pool);
+	}
+	auto const buffer = slideproj::pixel_store::make_pooled_pixel_buffer<uint8_t>(2 << 20, pool);
+	auto const stats = pool.stats();
+	EXPECT_EQ(stats.hits, 0);
+	EXPECT_EQ(stats.misses, 2);
+	EXPECT_EQ(stats.cached_bytes, 1 << 20);
+	EXPECT_EQ(stats.resident_bytes, 3 << 20);
+}
+
+TESTCASE(slideproj_pixel_store_pixel_buffer_pool_respects_cache_limit)
+{
+	slideproj::pixel_store::pixel_buffer_pool pool{
+		slideproj::pixel_store::pixel_buffer_pool_descriptor{
+			.max_cached_bytes = 1 << 20,
+			.use_huge_pages = false
+		}
+	};
+	{
+		auto const a = slideproj::pixel_store::make_pooled_pixel_buffer<uint8_t>(1 << 20, pool);
+		auto const b = slideproj::pixel_store::make_pooled_pixel_buffer<uint8_t>(1 << 20, pool);
+	}
+
+	auto const stats = pool.stats();
+	EXPECT_EQ(stats.cached_bytes, 1 << 20);
+	EXPECT_EQ(stats.resident_bytes, 1 << 20);
+
+	pool.trim();
+	EXPECT_EQ(pool.stats().cached_bytes, 0);
+	EXPECT_EQ(pool.stats().resident_bytes, 0);
+}
+
+TESTCASE(slideproj_pixel_store_pixel_buffer_pool_huge_pages)
+{
+	slideproj::pixel_store::pixel_buffer_pool pool{
+		slideproj::pixel_store::pixel_buffer_pool_descriptor{
+			.max_cached_bytes = 0,
+			.use_huge_pages = true
+		}
+	};
+	auto const buffer = slideproj::pixel_store::make_pooled_pixel_buffer<uint64_t>(1 << 20, pool);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.get()) % (2 << 20), 0);
+	std::fill_n(buffer.get(), 1 << 20, 0xdeadbeef);
+	EXPECT_EQ(buffer[(1 << 20) - 1], 0xdeadbeef);
+}
+
+TESTCASE(slideproj_pixel_store_pixel_buffer_pool_empty)
+{
+	slideproj::pixel_store::pixel_buffer_pool pool;
+	auto const buffer = slideproj::pixel_store::make_pooled_pixel_buffer<float>(0, pool);
+	EXPECT_EQ(buffer == nullptr, true);
+	EXPECT_EQ(pool.stats().misses, 0);
+}
+
+TESTCASE(slideproj_pixel_store_pixel_buffer_pool_size_overflow)
+{
+	slideproj::pixel_store::pixel_buffer_pool pool;
+	auto const count = std::numeric_limits<size_t>::max()/2;
+
+	// NOTE: Here, count*sizeof(T) wraps around
+	auto failed = false;
+	try
+	{ slideproj::pixel_store::make_pooled_pixel_buffer<uint64_t>(count, pool); }
+	catch(std::runtime_error const&)
+	{ failed = true; }
+	EXPECT_EQ(failed, true);
+
+	// NOTE: Here, rounding up to the size class would wrap around
+	failed = false;
+	try
+	{ slideproj::pixel_store::make_pooled_pixel_buffer<uint8_t>(count, pool); }
+	catch(std::runtime_error const&)
+	{ failed = true; }
+	EXPECT_EQ(failed, true);
+
+	EXPECT_EQ(pool.stats().misses, 0);
+}
@@ -5,6 +5,8 @@
 
 #include <cmath>
 #include <array>
+#include <cstdint>
+#include <memory>
 
 namespace slideproj::pixel_store
 {
@@ -15,45 +17,78 @@ namespace slideproj::pixel_store
 		{ return utils::to_normalized_float(value); }
 	};
 
-	template<class T>
-	consteval auto make_srgb_to_lin_lut()
+	template<class Function>
+	consteval auto make_u8_to_linear_lut(Function to_linear)
 	{
 		std::array<float, 256> ret{};
 		for(size_t k = 0; k != std::size(ret); ++k)
-		{
-			auto const value = static_cast<T>(k);
-			auto const val = utils::to_normalized_float(value);
-			ret[k] = (val <= 0.04045f)? val/12.92f : std::pow((val + 0.055f)/1.055f, 2.4f);
-		}
+		{ ret[k] = to_linear(utils::to_normalized_float(static_cast<uint8_t>(k))); }
+
+		return ret;
+	}
+
+	// NOTE: The table is 256 kB, so it is allocated on the heap
+	template<class Function>
+	auto make_u16_to_linear_lut(Function to_linear)
+	{
+		auto ret = std::make_unique_for_overwrite<std::array<float, 65536>>();
+		for(size_t k = 0; k != std::size(*ret); ++k)
+		{ (*ret)[k] = to_linear(utils::to_normalized_float(static_cast<uint16_t>(k))); }
 
 		return ret;
 	}
 
 	struct srgb_intensity_mapping
 	{
+		static constexpr float to_linear(float val)
+		{ return (val <= 0.04045f)? val/12.92f : std::pow((val + 0.055f)/1.055f, 2.4f); }
+
+		static auto const& get_u16_lut()
+		{
+			static auto const ret = make_u16_to_linear_lut(to_linear);
+			return *ret;
+		}
+
 		template<class T>
 		static constexpr float to_linear_float(T value)
 		{
 			if constexpr(std::is_same_v<T, uint8_t>)
 			{
-				static constexpr auto srgb_lut = make_srgb_to_lin_lut<T>();
-				return srgb_lut[value];
+				static constexpr auto lut = make_u8_to_linear_lut(to_linear);
+				return lut[value];
 			}
 			else
-			{
-				auto const val = utils::to_normalized_float(value);
-				return (val <= 0.04045f)? val/12.92f : std::pow((val + 0.055f)/1.055f, 2.4f);
-			}
+			if constexpr(std::is_same_v<T, uint16_t>)
+			{ return get_u16_lut()[value]; }
+			else
+			{ return to_linear(utils::to_normalized_float(value)); }
 		}
 	};
 
 	struct g22_intensity_mapping
 	{
+		static constexpr float to_linear(float val)
+		{ return std::pow(val, 2.2f); }
+
+		static auto const& get_u16_lut()
+		{
+			static auto const ret = make_u16_to_linear_lut(to_linear);
+			return *ret;
+		}
+
 		template<class T>
 		static constexpr float to_linear_float(T value)
 		{
-			auto const val = utils::to_normalized_float(value);
-			return std::pow(val, 2.2f);
+			if constexpr(std::is_same_v<T, uint8_t>)
+			{
+				static constexpr auto lut = make_u8_to_linear_lut(to_linear);
+				return lut[value];
+			}
+			else
+			if constexpr(std::is_same_v<T, uint16_t>)
+			{ return get_u16_lut()[value]; }
+			else
+			{ return to_linear(utils::to_normalized_float(value)); }
 		}
 	};
 
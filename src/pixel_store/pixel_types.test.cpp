@@ -0,0 +1,50 @@
+//@	{"target":{"name":"pixel_types.test"}}
+
+#include "./pixel_types.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+	template<class T, class IntensityTransferFunction, class ExactFunction>
+	double get_max_lut_error(ExactFunction exact)
+	{
+		auto max_error = 0.0;
+		for(uint32_t k = 0; k <= std::numeric_limits<T>::max(); ++k)
+		{
+			auto const value = static_cast<T>(k);
+			auto const expected = exact(static_cast<double>(k)/static_cast<double>(std::numeric_limits<T>::max()));
+			auto const res = static_cast<double>(IntensityTransferFunction::to_linear_float(value));
+			max_error = std::max(max_error, std::abs(res - expected));
+		}
+		return max_error;
+	}
+
+	double srgb_to_linear(double val)
+	{ return (val <= 0.04045)? val/12.92 : std::pow((val + 0.055)/1.055, 2.4); }
+
+	double g22_to_linear(double val)
+	{ return std::pow(val, 2.2); }
+}
+
+TESTCASE(slideproj_pixel_store_srgb_intensity_mapping_lut)
+{
+	using slideproj::pixel_store::srgb_intensity_mapping;
+	EXPECT_LT((get_max_lut_error<uint8_t, srgb_intensity_mapping>(srgb_to_linear)), 1.0e-6);
+	EXPECT_LT((get_max_lut_error<uint16_t, srgb_intensity_mapping>(srgb_to_linear)), 1.0e-6);
+	EXPECT_EQ(srgb_intensity_mapping::to_linear_float(static_cast<uint16_t>(0)), 0.0f);
+	EXPECT_EQ(srgb_intensity_mapping::to_linear_float(static_cast<uint16_t>(65535)), 1.0f);
+}
+
+TESTCASE(slideproj_pixel_store_g22_intensity_mapping_lut)
+{
+	using slideproj::pixel_store::g22_intensity_mapping;
+	EXPECT_LT((get_max_lut_error<uint8_t, g22_intensity_mapping>(g22_to_linear)), 1.0e-6);
+	EXPECT_LT((get_max_lut_error<uint16_t, g22_intensity_mapping>(g22_to_linear)), 1.0e-6);
+	EXPECT_EQ(g22_intensity_mapping::to_linear_float(static_cast<uint16_t>(0)), 0.0f);
+	EXPECT_EQ(g22_intensity_mapping::to_linear_float(static_cast<uint16_t>(65535)), 1.0f);
+}
@@ -5,6 +5,7 @@
 #include "./gl_types.hpp"
 
 #include "src/pixel_store/rgba_image.hpp"
+#include "src/pixel_store/packed_rgba_image.hpp"
 
 #include <bit>
 #include <cassert>
@@ -25,6 +26,7 @@ namespace slideproj::renderer
 		GLsizei height;
 		GLenum format;
 		GLenum type;
+		GLenum color_encoding;
 		GLsizei num_mipmaps;
 
 		auto operator<=>(gl_texture_descriptor const& other) const = default;
@@ -38,8 +40,8 @@ namespace slideproj::renderer
 	template<class T>
 	struct to_gl_color_channel_layout;
 
-	template<>
-	struct to_gl_color_channel_layout<pixel_store::rgba_pixel>
+	template<class SampleType>
+	struct to_gl_color_channel_layout<pixel_store::pixel_type<SampleType, 4>>
 	{
 		static constexpr auto value = GL_RGBA;
 	};
@@ -47,12 +49,44 @@ namespace slideproj::renderer
 	template<class T>
 	constexpr auto to_gl_color_channel_layout_v = to_gl_color_channel_layout<T>::value;
 
+	template<>
+	struct to_gl_type_id<pixel_store::srgb8_sample>
+	{
+		static constexpr auto value = GL_UNSIGNED_BYTE;
+	};
+
+	template<class T>
+	struct to_gl_color_encoding
+	{
+		static constexpr auto value = to_gl_color_encoding<typename T::sample_type>::value;
+	};
+
+	template<class T>
+	requires(std::is_arithmetic_v<T> || std::is_same_v<T, Imath::half>)
+	struct to_gl_color_encoding<T>
+	{
+		static constexpr auto value = GL_LINEAR;
+	};
+
+	template<>
+	struct to_gl_color_encoding<pixel_store::srgb8_sample>
+	{
+		static constexpr auto value = GL_SRGB;
+	};
+
+	template<class T>
+	constexpr auto to_gl_color_encoding_v = to_gl_color_encoding<T>::value;
+
 	inline GLenum gl_make_sized_format_red(GLenum type)
 	{
 		switch(type)
 		{
 			case GL_FLOAT:
 				return GL_R32F;
+			case GL_HALF_FLOAT:
+				return GL_R16F;
+			case GL_UNSIGNED_BYTE:
+				return GL_R8;
 			default:
 				throw std::runtime_error{"Unimplemented type"};
 		}
@@ -64,6 +98,10 @@ namespace slideproj::renderer
 		{
 			case GL_FLOAT:
 				return GL_RG32F;
+			case GL_HALF_FLOAT:
+				return GL_RG16F;
+			case GL_UNSIGNED_BYTE:
+				return GL_RG8;
 			default:
 				throw std::runtime_error{"Unimplemented type"};
 		}
@@ -75,6 +113,10 @@ namespace slideproj::renderer
 		{
 			case GL_FLOAT:
 				return GL_RGB32F;
+			case GL_HALF_FLOAT:
+				return GL_RGB16F;
+			case GL_UNSIGNED_BYTE:
+				return GL_RGB8;
 			default:
 				throw std::runtime_error{"Unimplemented type"};
 		}
@@ -86,6 +128,10 @@ namespace slideproj::renderer
 		{
 			case GL_FLOAT:
 				return GL_RGBA32F;
+			case GL_HALF_FLOAT:
+				return GL_RGBA16F;
+			case GL_UNSIGNED_BYTE:
+				return GL_RGBA8;
 			default:
 				throw std::runtime_error{"Unimplemented type"};
 		}
@@ -108,12 +154,36 @@ namespace slideproj::renderer
 		}
 	}
 
+	inline GLenum gl_make_sized_format(GLenum format, GLenum type, GLenum color_encoding)
+	{
+		if(color_encoding != GL_SRGB)
+		{ return gl_make_sized_format(format, type); }
+
+		// NOTE: sRGB decoding is only available for 8-bit RGB(A) textures
+		if(type != GL_UNSIGNED_BYTE)
+		{ throw std::runtime_error{"Unimplemented type"}; }
+
+		switch(format)
+		{
+			case GL_RGB:
+				return GL_SRGB8;
+			case GL_RGBA:
+				return GL_SRGB8_ALPHA8;
+			default:
+				throw std::runtime_error{"Unimplemented format"};
+		}
+	}
+
 	inline size_t gl_get_sample_size(GLenum type)
 	{
 		switch(type)
 		{
 			case GL_FLOAT:
 				return 4;
+			case GL_HALF_FLOAT:
+				return 2;
+			case GL_UNSIGNED_BYTE:
+				return 1;
 			default:
 				throw std::runtime_error{"Unimplemented type"};
 		}
@@ -144,7 +214,7 @@ namespace slideproj::renderer
 	class gl_texture
 	{
 	public:
-		explicit gl_texture():m_descriptor{0, 0, 0, 0, 0}
+		explicit gl_texture():m_descriptor{0, 0, 0, 0, 0, 0}
 		{ }
 
 		template<class T>
@@ -172,6 +242,7 @@ namespace slideproj::renderer
 				static_cast<GLsizei>(pixels.height()),
 				to_gl_color_channel_layout<T>::value,
 				to_gl_type_id_v<T>,
+				to_gl_color_encoding_v<T>,
 				std::max(static_cast<GLsizei>(std::bit_width(std::max(pixels.width(), pixels.height()) - 1)), 1)
 			};
 
@@ -182,6 +253,12 @@ namespace slideproj::renderer
 			return upload(std::as_bytes(pixel_array), descriptor);
 		}
 
+		auto& upload(pixel_store::packed_rgba_image const& pixels)
+		{
+			pixels.visit([this](auto const& item){ upload(item); });
+			return *this;
+		}
+
 		auto& upload(std::span<std::byte const> data)
 		{
 			auto const image_size = get_image_size(m_descriptor);
@@ -204,7 +281,7 @@ namespace slideproj::renderer
 
 			glTextureStorage2D(handle,
 				descriptor.num_mipmaps,
-				gl_make_sized_format(descriptor.format, descriptor.type),
+				gl_make_sized_format(descriptor.format, descriptor.type, descriptor.color_encoding),
 				descriptor.width,
 				descriptor.height);
 
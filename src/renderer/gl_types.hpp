@@ -1,6 +1,7 @@
 //@	{
 //@	 "dependencies":[
-//@			{"ref": "glew", "origin":"pkg-config"}
+//@			{"ref": "glew", "origin":"pkg-config"},
+//@			{"ref": "Imath", "origin":"pkg-config"}
 //@		]
 //@	}
 
@@ -9,6 +10,7 @@
 
 #include <GL/glew.h>
 #include <GL/gl.h>
+#include <Imath/half.h>
 
 namespace slideproj::renderer
 {
@@ -24,6 +26,12 @@ namespace slideproj::renderer
 		static constexpr auto value = GL_FLOAT;
 	};
 
+	template<>
+	struct to_gl_type_id<Imath::half>
+	{
+		static constexpr auto value = GL_HALF_FLOAT;
+	};
+
 	template<>
 	struct to_gl_type_id<unsigned int>
 	{
@@ -6,7 +6,7 @@
 #include "./gl_texture.hpp"
 
 #include "src/pixel_store/basic_image.hpp"
-#include "src/pixel_store/rgba_image.hpp"
+#include "src/pixel_store/packed_rgba_image.hpp"
 
 namespace slideproj::renderer
 {
@@ -25,7 +25,7 @@ namespace slideproj::renderer
 			m_shader_program.set_uniform(2, 1.0f);
 		}
 
-		void show_image(pixel_store::rgba_image const& img)
+		void show_image(pixel_store::packed_rgba_image const& img)
 		{
 			std::swap(m_next_image, m_current_image);
 			auto const w = img.width();
@@ -33,21 +33,34 @@ namespace slideproj::renderer
 			m_next_image.aspect_ratio = static_cast<float>(w)/static_cast<float>(h);
 			update_scale();
 			m_next_image.texture.upload(img);
+			m_needs_redraw = true;
 		}
 
 		void set_window_size(pixel_store::image_rectangle const& rect)
 		{
 			m_output_aspect_ratio = static_cast<float>(rect.width)/static_cast<float>(rect.height);
 			update_scale();
+			m_needs_redraw = true;
 		}
 
 		void set_transition_param(float t)
 		{
-			m_shader_program.set_uniform(2, std::clamp(t, 0.0f, 1.0f));
+			t = std::clamp(t, 0.0f, 1.0f);
+			if(t == m_transition_param)
+			{ return; }
+
+			m_shader_program.set_uniform(2, t);
+			m_transition_param = t;
+			m_needs_redraw = true;
 		}
 
+		// Returns true if the output has changed since the previous call to update
+		bool needs_redraw() const
+		{ return m_needs_redraw; }
+
 		void update()
 		{
+			m_needs_redraw = false;
 			m_shader_program.bind();
 			m_mesh.bind();
 			m_current_image.texture.bind(0);
@@ -98,6 +111,8 @@ namespace slideproj::renderer
 
 	private:
 		float m_output_aspect_ratio = 1.0f;
+		float m_transition_param = 1.0f;
+		bool m_needs_redraw = true;
 
 		image_to_display m_current_image;
 		image_to_display m_next_image;
@@ -0,0 +1,131 @@
+//@	{"target": {"name":"mapped_file.o"}}
+
+#include "./mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	struct file_descriptor
+	{
+		explicit file_descriptor(int value):fd{value}
+		{}
+
+		~file_descriptor()
+		{ ::close(fd); }
+
+		file_descriptor(file_descriptor const&) = delete;
+		file_descriptor& operator=(file_descriptor const&) = delete;
+
+		int fd;
+	};
+
+	bool is_network_filesystem(int fd)
+	{
+		struct statfs statbuf{};
+		if(::fstatfs(fd, &statbuf) == -1)
+		{ return false; }
+
+		switch(static_cast<uint32_t>(statbuf.f_type))
+		{
+			case 0x6969:      // NFS
+			case 0x517b:      // SMB
+			case 0xff534d42:  // CIFS
+			case 0xfe534d42:  // SMB2
+			case 0x65735546:  // FUSE
+			case 0x00c36400:  // Ceph
+			case 0x5346414f:  // AFS
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	std::pair<std::unique_ptr<char[]>, size_t>
+	read_file(int fd, std::filesystem::path const& path, size_t capacity)
+	{
+		size_t size = 0;
+		auto buffer = std::make_unique_for_overwrite<char[]>(capacity);
+		while(true)
+		{
+			if(size == capacity)
+			{
+				auto new_buffer = std::make_unique_for_overwrite<char[]>(2*capacity);
+				memcpy(new_buffer.get(), buffer.get(), size);
+				buffer = std::move(new_buffer);
+				capacity *= 2;
+			}
+
+			auto const res = ::read(fd, buffer.get() + size, capacity - size);
+			if(res == 0)
+			{ break; }
+
+			if(res == -1)
+			{
+				if(errno == EINTR)
+				{ continue; }
+				throw std::runtime_error{std::format("Failed to read {}: {}", path.c_str(), strerror(errno))};
+			}
+
+			size += static_cast<size_t>(res);
+		}
+		return std::pair{std::move(buffer), size};
+	}
+}
+
+slideproj::utils::mapped_file::mapped_file(std::filesystem::path const& path, mapped_file_mode mode)
+{
+	file_descriptor const file{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+	if(file.fd == -1)
+	{ throw std::runtime_error{std::format("Failed to open {}: {}", path.c_str(), strerror(errno))}; }
+
+	struct stat statbuf{};
+	if(::fstat(file.fd, &statbuf) == -1)
+	{ throw std::runtime_error{std::format("Failed to open {}: {}", path.c_str(), strerror(errno))}; }
+
+	if(S_ISREG(statbuf.st_mode))
+	{
+		auto const size = static_cast<size_t>(statbuf.st_size);
+		if(size == 0)
+		{ return; }
+
+		// NOTE: Page faults on a network filesystem may each cost a round trip. Reading the whole
+		//       file with one large request is faster.
+		if(mode == mapped_file_mode::preload && is_network_filesystem(file.fd))
+		{
+			auto buffer = read_file(file.fd, path, size + 1);
+			m_data = std::span{static_cast<char const*>(buffer.first.get()), buffer.second};
+			m_buffer = std::move(buffer.first);
+			return;
+		}
+
+		auto const flags = MAP_PRIVATE | (mode == mapped_file_mode::preload? MAP_POPULATE : 0);
+		auto const ptr = ::mmap(nullptr, size, PROT_READ, flags, file.fd, 0);
+		if(ptr == MAP_FAILED)
+		{ throw std::runtime_error{std::format("Failed to map {}: {}", path.c_str(), strerror(errno))}; }
+
+		m_data = std::span{static_cast<char const*>(ptr), size};
+		m_is_mapped = true;
+		return;
+	}
+
+	auto buffer = read_file(file.fd, path, 65536);
+	m_data = std::span{static_cast<char const*>(buffer.first.get()), buffer.second};
+	m_buffer = std::move(buffer.first);
+}
+
+slideproj::utils::mapped_file::~mapped_file()
+{
+	if(m_is_mapped)
+	{ ::munmap(const_cast<char*>(std::data(m_data)), std::size(m_data)); }
+}
@@ -0,0 +1,52 @@
+//@	{"dependencies_extra":[{"ref":"./mapped_file.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_UTILS_MAPPED_FILE_HPP
+#define SLIDEPROJ_UTILS_MAPPED_FILE_HPP
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace slideproj::utils
+{
+	// on_demand: Pages are read as they are touched
+	// preload: The whole file is read up front, so later accesses never wait for the disk
+	enum class mapped_file_mode{on_demand, preload};
+
+	// NOTE: Regular files are memory mapped. Other files, such as pipes, cannot be mapped, and are read
+	//       into memory instead.
+	class mapped_file
+	{
+	public:
+		mapped_file() = default;
+
+		explicit mapped_file(std::filesystem::path const& path, mapped_file_mode mode = mapped_file_mode::on_demand);
+
+		mapped_file(mapped_file&& other) noexcept:
+			m_data{std::exchange(other.m_data, std::span<char const>{})},
+			m_is_mapped{std::exchange(other.m_is_mapped, false)},
+			m_buffer{std::move(other.m_buffer)}
+		{}
+
+		mapped_file& operator=(mapped_file&& other) noexcept
+		{
+			std::swap(m_data, other.m_data);
+			std::swap(m_is_mapped, other.m_is_mapped);
+			std::swap(m_buffer, other.m_buffer);
+			return *this;
+		}
+
+		~mapped_file();
+
+		std::span<char const> data() const
+		{ return m_data; }
+
+	private:
+		std::span<char const> m_data;
+		bool m_is_mapped{false};
+		std::unique_ptr<char[]> m_buffer;
+	};
+}
+
+#endif
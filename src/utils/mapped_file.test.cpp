@@ -0,0 +1,69 @@
+//@	{"target":{"name":"mapped_file.test"}}
+
+#include "./mapped_file.hpp"
+
+#include "testfwk/testfwk.hpp"
+#include "testfwk/validation.hpp"
+
+#include <unistd.h>
+#include <array>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+	std::string_view as_string_view(std::span<char const> data)
+	{ return std::string_view{std::data(data), std::size(data)}; }
+}
+
+TESTCASE(slideproj_utils_mapped_file_regular_file)
+{
+	auto const filename = std::filesystem::temp_directory_path()/"slideproj_mapped_file_test.dat";
+	{
+		std::ofstream output{filename, std::ios::binary};
+		output << "Hello, World";
+	}
+
+	slideproj::utils::mapped_file file{filename};
+	EXPECT_EQ(as_string_view(file.data()), "Hello, World");
+
+	auto other = std::move(file);
+	EXPECT_EQ(as_string_view(other.data()), "Hello, World");
+	EXPECT_EQ(std::size(file.data()), 0);
+}
+
+TESTCASE(slideproj_utils_mapped_file_empty_file)
+{
+	auto const filename = std::filesystem::temp_directory_path()/"slideproj_mapped_file_test_empty.dat";
+	{ std::ofstream output{filename, std::ios::binary}; }
+
+	slideproj::utils::mapped_file const file{filename};
+	EXPECT_EQ(std::size(file.data()), 0);
+}
+
+TESTCASE(slideproj_utils_mapped_file_pipe)
+{
+	std::array<int, 2> fds{};
+	REQUIRE_EQ(pipe(std::data(fds)), 0);
+	std::string_view const message{"Hello from a pipe"};
+	REQUIRE_EQ(write(fds[1], std::data(message), std::size(message)), std::ssize(message));
+	close(fds[1]);
+
+	slideproj::utils::mapped_file const file{std::filesystem::path{"/proc/self/fd"}/std::to_string(fds[0])};
+	close(fds[0]);
+	EXPECT_EQ(as_string_view(file.data()), message);
+}
+
+TESTCASE(slideproj_utils_mapped_file_preload)
+{
+	auto const filename = std::filesystem::temp_directory_path()/"slideproj_mapped_file_test_preload.dat";
+	std::string const content(100000, 'A');
+	{
+		std::ofstream output{filename, std::ios::binary};
+		output << content;
+	}
+
+	slideproj::utils::mapped_file const file{filename, slideproj::utils::mapped_file_mode::preload};
+	EXPECT_EQ(as_string_view(file.data()), content);
+}
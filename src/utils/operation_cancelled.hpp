@@ -0,0 +1,24 @@
+#ifndef SLIDEPROJ_UTILS_OPERATION_CANCELLED_HPP
+#define SLIDEPROJ_UTILS_OPERATION_CANCELLED_HPP
+
+#include <exception>
+#include <stop_token>
+
+namespace slideproj::utils
+{
+	// Thrown by work that gives up early, because a stop has been requested
+	class operation_cancelled : public std::exception
+	{
+	public:
+		char const* what() const noexcept override
+		{ return "Operation cancelled"; }
+	};
+
+	inline void throw_if_stop_requested(std::stop_token const& stop_token)
+	{
+		if(stop_token.stop_requested())
+		{ throw operation_cancelled{}; }
+	}
+}
+
+#endif
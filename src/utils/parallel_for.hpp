@@ -0,0 +1,54 @@
+#ifndef SLIDEPROJ_UTILS_PARALLEL_FOR_HPP
+#define SLIDEPROJ_UTILS_PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace slideproj::utils
+{
+	// NOTE: The calling thread participates, so worker_count - 1 threads are started. Items are
+	//       handed out one at a time, which suits I/O bound work where items differ in cost.
+	template<class Callable>
+	void parallel_for(size_t item_count, size_t worker_count, Callable&& func)
+	{
+		std::atomic<size_t> next_item{0};
+		std::atomic<bool> failed{false};
+		std::mutex error_mutex;
+		std::exception_ptr error;
+		auto run = [&]() {
+			while(!failed.load(std::memory_order_relaxed))
+			{
+				auto const k = next_item.fetch_add(1, std::memory_order_relaxed);
+				if(k >= item_count)
+				{ return; }
+
+				try
+				{ func(k); }
+				catch(...)
+				{
+					std::lock_guard lock{error_mutex};
+					if(error == nullptr)
+					{ error = std::current_exception(); }
+					failed = true;
+				}
+			}
+		};
+
+		{
+			std::vector<std::jthread> workers;
+			auto const thread_count = std::min(worker_count, item_count);
+			for(size_t k = 1; k < thread_count; ++k)
+			{ workers.push_back(std::jthread{run}); }
+			run();
+		}
+
+		if(error != nullptr)
+		{ std::rethrow_exception(error); }
+	}
+}
+
+#endif
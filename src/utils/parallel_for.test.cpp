@@ -0,0 +1,42 @@
+//@	{"target":{"name":"parallel_for.test"}}
+
+#include "./parallel_for.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+TESTCASE(slideproj_utils_parallel_for_visits_all_items_once)
+{
+	std::vector<std::atomic<int>> visited(1000);
+	slideproj::utils::parallel_for(std::size(visited), 4, [&visited](size_t k){
+		++visited[k];
+	});
+
+	EXPECT_EQ(std::ranges::all_of(visited, [](auto const& item){ return item == 1; }), true);
+}
+
+TESTCASE(slideproj_utils_parallel_for_no_items)
+{
+	size_t call_count = 0;
+	slideproj::utils::parallel_for(0, 4, [&call_count](size_t){ ++call_count; });
+	EXPECT_EQ(call_count, 0);
+}
+
+TESTCASE(slideproj_utils_parallel_for_rethrows)
+{
+	std::string message;
+	try
+	{
+		slideproj::utils::parallel_for(100, 4, [](size_t k){
+			if(k == 50)
+			{ throw std::runtime_error{"Error"}; }
+		});
+	}
+	catch(std::runtime_error const& err)
+	{ message = err.what(); }
+
+	EXPECT_EQ(message, "Error");
+}
@@ -0,0 +1,63 @@
+#ifndef SLIDEPROJ_UTILS_STRING_ARENA_HPP
+#define SLIDEPROJ_UTILS_STRING_ARENA_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace slideproj::utils
+{
+	// NOTE: Strings are packed into large chunks that are never moved or freed before the arena
+	//       itself, so a view returned by insert stays valid for the lifetime of the arena, also after
+	//       the arena has been moved. Each string is followed by a null terminator.
+	class string_arena
+	{
+	public:
+		static constexpr size_t chunk_size = 65536;
+
+		string_arena() = default;
+
+		string_arena(string_arena&& other) noexcept:
+			m_chunks{std::move(other.m_chunks)},
+			m_write_ptr{std::exchange(other.m_write_ptr, nullptr)},
+			m_free_space{std::exchange(other.m_free_space, 0)}
+		{}
+
+		string_arena& operator=(string_arena&& other) noexcept
+		{
+			m_chunks = std::move(other.m_chunks);
+			m_write_ptr = std::exchange(other.m_write_ptr, nullptr);
+			m_free_space = std::exchange(other.m_free_space, 0);
+			return *this;
+		}
+
+		std::string_view insert(std::string_view str)
+		{
+			auto const required_size = std::size(str) + 1;
+			if(required_size > m_free_space)
+			{
+				auto const new_chunk_size = std::max(chunk_size, required_size);
+				m_chunks.push_back(std::make_unique_for_overwrite<char[]>(new_chunk_size));
+				m_write_ptr = m_chunks.back().get();
+				m_free_space = new_chunk_size;
+			}
+
+			auto const ret = m_write_ptr;
+			memcpy(ret, std::data(str), std::size(str));
+			ret[std::size(str)] = '\0';
+			m_write_ptr += required_size;
+			m_free_space -= required_size;
+			return std::string_view{ret, std::size(str)};
+		}
+
+	private:
+		std::vector<std::unique_ptr<char[]>> m_chunks;
+		char* m_write_ptr{nullptr};
+		size_t m_free_space{0};
+	};
+}
+
+#endif
@@ -0,0 +1,40 @@
+//@	{"target":{"name":"string_arena.test"}}
+
+#include "./string_arena.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <string>
+
+TESTCASE(slideproj_utils_string_arena_insert)
+{
+	slideproj::utils::string_arena arena;
+	auto const a = arena.insert("foo/bar.jpg");
+	auto const b = arena.insert("");
+	auto const c = arena.insert("foo/lenna.jpg");
+
+	EXPECT_EQ(a, "foo/bar.jpg");
+	EXPECT_EQ(b, "");
+	EXPECT_EQ(c, "foo/lenna.jpg");
+	EXPECT_EQ(std::data(a)[std::size(a)], '\0');
+	EXPECT_EQ(std::data(c)[std::size(c)], '\0');
+}
+
+TESTCASE(slideproj_utils_string_arena_views_survive_growth_and_move)
+{
+	slideproj::utils::string_arena arena;
+	auto const first = arena.insert("first");
+	std::string const large(3*slideproj::utils::string_arena::chunk_size, 'x');
+	auto const large_view = arena.insert(large);
+	for(size_t k = 0; k != 16384; ++k)
+	{ arena.insert(std::to_string(k)); }
+
+	auto other = std::move(arena);
+	auto const last = other.insert("last");
+	auto const after_move = arena.insert("after move");
+
+	EXPECT_EQ(first, "first");
+	EXPECT_EQ(large_view, large);
+	EXPECT_EQ(last, "last");
+	EXPECT_EQ(after_move, "after move");
+}
@@ -1,13 +1,25 @@
 #ifndef SLIDEPROJ_UTILS_TASK_QUEUE_HPP
 #define SLIDEPROJ_UTILS_TASK_QUEUE_HPP
 
+#include "./operation_cancelled.hpp"
+
+#include <algorithm>
+#include <atomic>
 #include <concepts>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
 #include <thread>
-#include <queue>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 namespace slideproj::utils
 {
+	enum class task_priority{low, medium, high};
+
 	class task_completion_handler
 	{
 	public:
@@ -19,8 +31,17 @@ namespace slideproj::utils
 		void finalize()
 		{ m_handler(); }
 
+		// NOTE: The priority the task had when it completed. A result buffer may use it to decide
+		//       which results to process first.
+		task_priority priority() const
+		{ return m_priority; }
+
+		void set_priority(task_priority priority)
+		{ m_priority = priority; }
+
 	private:
 		std::move_only_function<void()> m_handler{};
+		task_priority m_priority{task_priority::medium};
 	};
 
 	template<class Function, class OnCompleted>
@@ -44,16 +65,34 @@ namespace slideproj::utils
 		void (*clear)(void* object);
 	};
 
+	struct task_id
+	{
+		size_t value;
+
+		constexpr bool operator==(task_id const&) const = default;
+		constexpr bool operator!=(task_id const&) const = default;
+	};
+
+	// Sets the I/O priority of the given thread, or the calling thread if thread_id is 0, so reads
+	// made by high priority tasks are served before reads made by low priority tasks
+	inline void set_io_priority(task_priority priority, pid_t thread_id = 0)
+	{
+		// NOTE: See ioprio_set(2). Within the best effort class, level 0 is the highest priority.
+		constexpr int ioprio_who_process = 1;
+		constexpr int ioprio_class_best_effort = 2;
+		constexpr int ioprio_class_shift = 13;
+		auto const level = priority == task_priority::high? 0 : (priority == task_priority::medium? 4 : 7);
+		::syscall(SYS_ioprio_set, ioprio_who_process, thread_id, (ioprio_class_best_effort << ioprio_class_shift) | level);
+	}
+
 	class task_queue
 	{
 	public:
+		// NOTE: Tasks with higher priority are started first. Tasks with the same priority are started
+		//       in the order they were submitted. With more than one worker, tasks may complete in any
+		//       order.
 		template<task_result_buffer ResultBuffer>
-		task_queue(ResultBuffer& res_buffer):
-			m_worker{
-				[this](){
-					run_tasks();
-				}
-			},
+		explicit task_queue(ResultBuffer& res_buffer, size_t worker_count = 1):
 			m_result_buffer{
 				.object = &res_buffer,
 				.push = [](void* object, task_completion_handler&& result) {
@@ -63,52 +102,161 @@ namespace slideproj::utils
 					static_cast<ResultBuffer*>(object)->clear();
 				}
 			}
-		{}
+		{
+			worker_count = std::max(worker_count, static_cast<size_t>(1));
+			m_workers.reserve(worker_count);
+			for(size_t k = 0; k != worker_count; ++k)
+			{ m_workers.push_back(std::thread{[this](){ run_tasks(); }}); }
+		}
+
+		task_queue(task_queue const&) = delete;
+		task_queue& operator=(task_queue const&) = delete;
 
+		size_t worker_count() const
+		{ return std::size(m_workers); }
+
+		// NOTE: func.function may accept a std::stop_token, followed by a task_priority. The stop
+		//       token is signaled when the task is cancelled. The priority can also be taken as a
+		//       std::atomic<task_priority> const&, which follows calls to raise_priority while the
+		//       task is running.
 		template<class Function, class OnCompleted>
-		void submit(task<Function, OnCompleted>&& func)
+		task_id submit(task<Function, OnCompleted>&& func, task_priority priority = task_priority::medium)
 		{
 			std::lock_guard lock{m_task_queue_mtx};
-			m_tasks.push(
-				[
+			task_id const id{m_next_task_id++};
+			m_tasks.push_back(queued_task{
+				.id = id,
+				.priority = priority,
+				.stop_source = std::stop_source{},
+				.run = [
 					on_completed = std::move(func.on_completed),
 					function = std::move(func.function)
-				]() mutable {
+				](std::stop_token const& stop_token, std::atomic<task_priority> const& current_priority) mutable {
 					return task_completion_handler{
 						[
 							on_completed = std::move(on_completed),
-							result = function()
+							result = invoke_task_function(function, stop_token, current_priority)
 						]() mutable {
 							on_completed(std::move(result));
 						}
 					};
 				}
-			);
+			});
 			m_task_queue_cv.notify_one();
+			return id;
+		}
+
+		// Raises the priority of a task that has not yet been completed. For a running task, the I/O
+		// priority of the thread running it is raised, and the new priority is published to the task.
+		// Returns false if the task has already completed.
+		bool raise_priority(task_id id, task_priority priority)
+		{
+			std::lock_guard lock{m_task_queue_mtx};
+			if(auto const i = std::ranges::find(m_tasks, id, &queued_task::id); i != std::end(m_tasks))
+			{
+				i->priority = std::max(i->priority, priority);
+				return true;
+			}
+
+			if(auto const i = std::ranges::find(m_running_tasks, id, &running_task::id); i != std::end(m_running_tasks))
+			{
+				if(priority > i->priority)
+				{
+					i->priority = priority;
+					i->current_priority->store(priority, std::memory_order_relaxed);
+					set_io_priority(priority, i->thread_id);
+				}
+				return true;
+			}
+			return false;
 		}
 
+		// Removes a task that has not yet been started, or asks a running task to stop. A cancelled
+		// task does not produce any result. Returns false if the task has already completed.
+		bool cancel(task_id id)
+		{
+			std::lock_guard lock{m_task_queue_mtx};
+			if(auto const i = std::ranges::find(m_tasks, id, &queued_task::id); i != std::end(m_tasks))
+			{
+				m_tasks.erase(i);
+				return true;
+			}
+
+			if(auto const i = std::ranges::find(m_running_tasks, id, &running_task::id); i != std::end(m_running_tasks))
+			{
+				i->stop_source.request_stop();
+				return true;
+			}
+			return false;
+		}
+
+		// Cancels all tasks, and throws away results that have not yet been processed
 		void clear()
 		{
 			m_worker_status = worker_status::suspended;
 			{
 				std::lock_guard lock{m_task_queue_mtx};
-				m_tasks = queue{};
+				m_tasks.clear();
+				for(auto& item : m_running_tasks)
+				{ item.stop_source.request_stop(); }
+				m_result_buffer.clear(m_result_buffer.object);
 			}
-			m_result_buffer.clear(m_result_buffer.object);
 			m_worker_status = worker_status::running;
-			m_task_queue_cv.notify_one();
+			m_task_queue_cv.notify_all();
 		}
 
 		~task_queue()
 		{
 			m_worker_status = worker_status::shutdown;
-			m_task_queue_cv.notify_one();
-			m_worker.join();
+			m_task_queue_cv.notify_all();
+			for(auto& item : m_workers)
+			{ item.join(); }
 		}
 
 	private:
+		// NOTE: A function that takes a task_priority by value gets the priority at the time the
+		//       task was started, through the conversion operator of std::atomic
+		template<class Function>
+		static decltype(auto) invoke_task_function(
+			Function& function,
+			std::stop_token const& stop_token,
+			std::atomic<task_priority> const& priority
+		)
+		{
+			if constexpr(std::invocable<Function&, std::stop_token const&, std::atomic<task_priority> const&>)
+			{ return function(stop_token, priority); }
+			else if constexpr(std::invocable<Function&, std::stop_token const&>)
+			{ return function(stop_token); }
+			else if constexpr(std::invocable<Function&, std::atomic<task_priority> const&>)
+			{ return function(priority); }
+			else
+			{ return function(); }
+		}
+
+		struct queued_task
+		{
+			task_id id;
+			task_priority priority;
+			std::stop_source stop_source;
+			std::move_only_function<
+				task_completion_handler(std::stop_token const&, std::atomic<task_priority> const&)
+			> run;
+		};
+
+		struct running_task
+		{
+			task_id id;
+			task_priority priority;
+			std::stop_source stop_source;
+			// NOTE: Points to the stack of the worker running the task. The worker removes the entry
+			//       before current_priority goes out of scope.
+			std::atomic<task_priority>* current_priority;
+			pid_t thread_id;
+		};
+
 		void run_tasks()
 		{
+			auto const thread_id = ::gettid();
 			while(true)
 			{
 				std::unique_lock task_queue_lock{m_task_queue_mtx};
@@ -123,30 +271,57 @@ namespace slideproj::utils
 				if(m_worker_status == worker_status::shutdown)
 				{ return; }
 
-				auto task_to_run = std::move(m_tasks.front());
-				m_tasks.pop();
+				// NOTE: Tasks are stored in submission order, so max_element picks the oldest task
+				//       among those with the highest priority
+				auto const i = std::ranges::max_element(m_tasks, std::less{}, &queued_task::priority);
+				auto task_to_run = std::move(*i);
+				m_tasks.erase(i);
+				std::atomic<task_priority> current_priority{task_to_run.priority};
+				m_running_tasks.push_back(running_task{
+					.id = task_to_run.id,
+					.priority = task_to_run.priority,
+					.stop_source = task_to_run.stop_source,
+					.current_priority = &current_priority,
+					.thread_id = thread_id
+				});
+				// NOTE: Set while holding the lock, so raise_priority cannot be overridden
+				set_io_priority(task_to_run.priority);
 				task_queue_lock.unlock();
+
+				auto const stop_token = task_to_run.stop_source.get_token();
+				std::optional<task_completion_handler> result;
 				try
-				{
-					m_result_buffer.push(m_result_buffer.object, task_to_run());
-				}
+				{ result = task_to_run.run(stop_token, current_priority); }
+				catch(operation_cancelled const&)
+				{}
 				catch(std::exception const& exception)
 				{ fprintf(stderr, "%s", exception.what()); }
+
+				// NOTE: The result is pushed while holding the lock, so it cannot slip in after clear
+				//       has emptied the result buffer
+				task_queue_lock.lock();
+				auto const running = std::ranges::find(m_running_tasks, task_to_run.id, &running_task::id);
+				if(result.has_value() && !stop_token.stop_requested())
+				{
+					result->set_priority(running->priority);
+					m_result_buffer.push(m_result_buffer.object, std::move(*result));
+				}
+				m_running_tasks.erase(running);
 			}
 		}
 
 		std::mutex m_task_queue_mtx;
 		std::condition_variable m_task_queue_cv;
-		using queue = std::queue<std::move_only_function<task_completion_handler()>>;
-		queue m_tasks;
+		std::vector<queued_task> m_tasks;
+		std::vector<running_task> m_running_tasks;
+		size_t m_next_task_id{0};
 
 		enum class worker_status{running, suspended, shutdown};
 
 		std::atomic<worker_status> m_worker_status{worker_status::running};
-		std::thread m_worker;
-
 		type_erased_task_result_buffer m_result_buffer;
+		std::vector<std::thread> m_workers;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
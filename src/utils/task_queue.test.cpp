@@ -0,0 +1,187 @@
+//@	{"target":{"name":"task_queue.test"}}
+
+#include "./task_queue.hpp"
+#include "./task_result_queue.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <atomic>
+#include <latch>
+#include <vector>
+
+TESTCASE(slideproj_utils_task_queue_runs_tasks_in_parallel)
+{
+	slideproj::utils::task_result_queue results;
+	size_t completed_count = 0;
+	{
+		slideproj::utils::task_queue tasks{results, 4};
+		EXPECT_EQ(tasks.worker_count(), 4);
+
+		// NOTE: This only finishes if all four tasks are running at the same time
+		std::latch all_started{4};
+		for(size_t k = 0; k != 4; ++k)
+		{
+			tasks.submit(
+				slideproj::utils::task{
+					.function = [&all_started, k](){
+						all_started.arrive_and_wait();
+						return k;
+					},
+					.on_completed = [&completed_count](size_t){ ++completed_count; }
+				}
+			);
+		}
+		all_started.wait();
+	}
+
+	results.drain();
+	EXPECT_EQ(completed_count, 4);
+}
+
+TESTCASE(slideproj_utils_task_queue_at_least_one_worker)
+{
+	slideproj::utils::task_result_queue results;
+	slideproj::utils::task_queue tasks{results, 0};
+	EXPECT_EQ(tasks.worker_count(), 1);
+}
+
+TESTCASE(slideproj_utils_task_queue_priority_order)
+{
+	slideproj::utils::task_result_queue results;
+	std::vector<int> start_order;
+	{
+		slideproj::utils::task_queue tasks{results, 1};
+
+		// NOTE: Keep the worker busy, so the remaining tasks are queued before any of them starts
+		std::latch started{1};
+		std::latch may_continue{1};
+		tasks.submit(
+			slideproj::utils::task{
+				.function = [&started, &may_continue, &start_order](){
+					start_order.push_back(0);
+					started.count_down();
+					may_continue.wait();
+					return 0;
+				},
+				.on_completed = [](int){}
+			}
+		);
+		started.wait();
+
+		std::latch finished{4};
+		auto const submit = [&tasks, &start_order, &finished](int value, slideproj::utils::task_priority priority) {
+			return tasks.submit(
+				slideproj::utils::task{
+					.function = [value, &start_order, &finished](slideproj::utils::task_priority){
+						// NOTE: There is only one worker, so tasks do not access start_order concurrently
+						start_order.push_back(value);
+						finished.count_down();
+						return value;
+					},
+					.on_completed = [](int){}
+				},
+				priority
+			);
+		};
+
+		submit(1, slideproj::utils::task_priority::low);
+		auto const raised = submit(2, slideproj::utils::task_priority::low);
+		submit(3, slideproj::utils::task_priority::medium);
+		submit(4, slideproj::utils::task_priority::high);
+		EXPECT_EQ(tasks.raise_priority(raised, slideproj::utils::task_priority::high), true);
+		EXPECT_EQ(tasks.raise_priority(slideproj::utils::task_id{1234}, slideproj::utils::task_priority::high), false);
+		may_continue.count_down();
+		finished.wait();
+	}
+
+	EXPECT_EQ(start_order, (std::vector{0, 2, 4, 3, 1}));
+}
+
+TESTCASE(slideproj_utils_task_queue_raise_priority_of_running_task)
+{
+	slideproj::utils::task_result_queue results;
+	slideproj::utils::task_priority observed_priority{slideproj::utils::task_priority::low};
+	long observed_io_priority = -1;
+	{
+		slideproj::utils::task_queue tasks{results, 1};
+
+		std::latch started{1};
+		std::latch may_continue{1};
+		auto const running = tasks.submit(
+			slideproj::utils::task{
+				.function = [&started, &may_continue, &observed_io_priority](
+					std::stop_token const&,
+					std::atomic<slideproj::utils::task_priority> const& priority
+				){
+					started.count_down();
+					may_continue.wait();
+					// NOTE: See ioprio_get(2). Returns the I/O priority of the calling thread.
+					observed_io_priority = ::syscall(SYS_ioprio_get, 1, 0);
+					return priority.load();
+				},
+				.on_completed = [&observed_priority](slideproj::utils::task_priority value){
+					observed_priority = value;
+				}
+			},
+			slideproj::utils::task_priority::low
+		);
+		started.wait();
+		EXPECT_EQ(tasks.raise_priority(running, slideproj::utils::task_priority::high), true);
+		may_continue.count_down();
+	}
+
+	results.drain();
+	EXPECT_EQ(observed_priority == slideproj::utils::task_priority::high, true);
+
+	// NOTE: ioprio_get may not be available in all environments
+	if(observed_io_priority != -1)
+	{ EXPECT_EQ(observed_io_priority, (2 << 13) | 0); }
+}
+
+TESTCASE(slideproj_utils_task_queue_cancel)
+{
+	slideproj::utils::task_result_queue results;
+	std::vector<int> completion_order;
+	{
+		slideproj::utils::task_queue tasks{results, 1};
+
+		std::latch started{1};
+		auto const running = tasks.submit(
+			slideproj::utils::task{
+				.function = [&started](std::stop_token const& stop_token){
+					started.count_down();
+					while(true)
+					{ slideproj::utils::throw_if_stop_requested(stop_token); }
+					return 0;
+				},
+				.on_completed = [&completion_order](int value){ completion_order.push_back(value); }
+			}
+		);
+		started.wait();
+
+		std::latch finished{1};
+		auto const queued = tasks.submit(
+			slideproj::utils::task{
+				.function = [](){ return 1; },
+				.on_completed = [&completion_order](int value){ completion_order.push_back(value); }
+			}
+		);
+		tasks.submit(
+			slideproj::utils::task{
+				.function = [&finished](){
+					finished.count_down();
+					return 2;
+				},
+				.on_completed = [&completion_order](int value){ completion_order.push_back(value); }
+			}
+		);
+
+		EXPECT_EQ(tasks.cancel(queued), true);
+		EXPECT_EQ(tasks.cancel(running), true);
+		finished.wait();
+		EXPECT_EQ(tasks.cancel(running), false);
+	}
+
+	results.drain();
+	EXPECT_EQ(completion_order, (std::vector{2}));
+}
@@ -3,45 +3,108 @@
 
 #include "./task_queue.hpp"
 
-#include <queue>
-#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <utility>
 
 namespace slideproj::utils
 {
+	// A multi-producer, single-consumer queue of task results. Producers never block, and the
+	// consumer only takes the lock-free list of new results once per call to drain.
 	class task_result_queue
 	{
 	public:
+		using clock = std::chrono::steady_clock;
+
+		task_result_queue() = default;
+		task_result_queue(task_result_queue const&) = delete;
+		task_result_queue& operator=(task_result_queue const&) = delete;
+
+		~task_result_queue()
+		{ delete_nodes(m_incoming.exchange(nullptr, std::memory_order_acquire)); }
+
 		void push(task_completion_handler&& obj)
 		{
-			std::lock_guard lock{m_mutex};
-			m_queue.push(std::move(obj));
+			auto const new_node = new node{std::move(obj), m_incoming.load(std::memory_order_relaxed)};
+			while(!m_incoming.compare_exchange_weak(
+				new_node->next,
+				new_node,
+				std::memory_order_release,
+				std::memory_order_relaxed
+			));
 		}
 
-		void drain()
+		// Processes results until the time budget has been used. High priority results are processed
+		// first, and are always processed. Other results are processed in the order they arrived, and
+		// those that do not fit within the budget are kept until the next call. Returns true if
+		// results are left.
+		//
+		// NOTE: Must only be called from the consumer thread
+		bool drain(clock::duration budget = clock::duration::max())
 		{
-			while(true)
-			{
-				std::unique_lock lock{m_mutex};
-				if(m_queue.empty())
-				{ return; }
-				auto val = std::move(m_queue.front());
-				m_queue.pop();
-				lock.unlock();
-				val.finalize();
-			}
+			take_incoming();
+			while(!m_high_priority.empty())
+			{ finalize_front(m_high_priority); }
+
+			// NOTE: Compare elapsed time rather than computing a deadline, so the default budget
+			//       does not overflow
+			auto const t0 = clock::now();
+			while(!m_other.empty() && clock::now() - t0 < budget)
+			{ finalize_front(m_other); }
+
+			return !m_other.empty();
 		}
 
+		// NOTE: Must only be called from the consumer thread
 		void clear()
 		{
-			std::lock_guard lock{m_mutex};
-			m_queue = queue{};
+			delete_nodes(m_incoming.exchange(nullptr, std::memory_order_acquire));
+			m_high_priority.clear();
+			m_other.clear();
 		}
 
 	private:
-		std::mutex m_mutex;
-		using queue = std::queue<task_completion_handler>;
-		queue m_queue;
+		struct node
+		{
+			task_completion_handler value;
+			node* next;
+		};
+
+		static void delete_nodes(node* head)
+		{
+			while(head != nullptr)
+			{ delete std::exchange(head, head->next); }
+		}
+
+		void take_incoming()
+		{
+			// NOTE: The incoming list is in reverse order of arrival
+			node* reversed = nullptr;
+			auto head = m_incoming.exchange(nullptr, std::memory_order_acquire);
+			while(head != nullptr)
+			{ reversed = std::exchange(head, std::exchange(head->next, reversed)); }
+
+			while(reversed != nullptr)
+			{
+				std::unique_ptr<node> current{std::exchange(reversed, reversed->next)};
+				auto& target = current->value.priority() == task_priority::high? m_high_priority : m_other;
+				target.push_back(std::move(current->value));
+			}
+		}
+
+		static void finalize_front(std::deque<task_completion_handler>& queue)
+		{
+			auto val = std::move(queue.front());
+			queue.pop_front();
+			val.finalize();
+		}
+
+		std::atomic<node*> m_incoming{nullptr};
+		std::deque<task_completion_handler> m_high_priority;
+		std::deque<task_completion_handler> m_other;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
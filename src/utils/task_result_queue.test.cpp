@@ -0,0 +1,87 @@
+//@	{"target":{"name":"task_result_queue.test"}}
+
+#include "./task_result_queue.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+	slideproj::utils::task_completion_handler make_handler(
+		std::vector<int>& completion_order,
+		int value,
+		slideproj::utils::task_priority priority
+	)
+	{
+		slideproj::utils::task_completion_handler ret{
+			[&completion_order, value](){ completion_order.push_back(value); }
+		};
+		ret.set_priority(priority);
+		return ret;
+	}
+}
+
+TESTCASE(slideproj_utils_task_result_queue_high_priority_first)
+{
+	slideproj::utils::task_result_queue results;
+	std::vector<int> completion_order;
+	results.push(make_handler(completion_order, 1, slideproj::utils::task_priority::low));
+	results.push(make_handler(completion_order, 2, slideproj::utils::task_priority::medium));
+	results.push(make_handler(completion_order, 3, slideproj::utils::task_priority::high));
+	results.push(make_handler(completion_order, 4, slideproj::utils::task_priority::low));
+
+	EXPECT_EQ(results.drain(), false);
+	EXPECT_EQ(completion_order, (std::vector{3, 1, 2, 4}));
+}
+
+TESTCASE(slideproj_utils_task_result_queue_drain_with_budget)
+{
+	slideproj::utils::task_result_queue results;
+	std::vector<int> completion_order;
+	results.push(make_handler(completion_order, 1, slideproj::utils::task_priority::low));
+	results.push(make_handler(completion_order, 2, slideproj::utils::task_priority::low));
+	results.push(make_handler(completion_order, 3, slideproj::utils::task_priority::high));
+
+	// NOTE: With an empty budget, only high priority results are processed
+	EXPECT_EQ(results.drain(slideproj::utils::task_result_queue::clock::duration::zero()), true);
+	EXPECT_EQ(completion_order, (std::vector{3}));
+
+	results.push(make_handler(completion_order, 4, slideproj::utils::task_priority::low));
+	EXPECT_EQ(results.drain(), false);
+	EXPECT_EQ(completion_order, (std::vector{3, 1, 2, 4}));
+}
+
+TESTCASE(slideproj_utils_task_result_queue_clear)
+{
+	slideproj::utils::task_result_queue results;
+	std::vector<int> completion_order;
+	results.push(make_handler(completion_order, 1, slideproj::utils::task_priority::low));
+	results.push(make_handler(completion_order, 2, slideproj::utils::task_priority::low));
+	EXPECT_EQ(results.drain(slideproj::utils::task_result_queue::clock::duration::zero()), true);
+	results.push(make_handler(completion_order, 3, slideproj::utils::task_priority::high));
+
+	results.clear();
+	EXPECT_EQ(results.drain(), false);
+	EXPECT_EQ(std::size(completion_order), 0);
+}
+
+TESTCASE(slideproj_utils_task_result_queue_multiple_producers)
+{
+	slideproj::utils::task_result_queue results;
+	size_t completed_count = 0;
+	{
+		std::vector<std::jthread> producers;
+		for(size_t k = 0; k != 4; ++k)
+		{
+			producers.push_back(std::jthread{[&results, &completed_count](){
+				for(size_t l = 0; l != 1000; ++l)
+				{ results.push(slideproj::utils::task_completion_handler{[&completed_count](){ ++completed_count; }}); }
+			}});
+		}
+	}
+
+	results.drain();
+	EXPECT_EQ(completed_count, 4000);
+}
@@ -0,0 +1,124 @@
+//@	{"target": {"name":"thread_pool.o"}}
+
+#include "./thread_pool.hpp"
+
+#include <algorithm>
+
+slideproj::utils::thread_pool::thread_pool(size_t thread_count)
+{
+	m_workers.reserve(thread_count);
+	for(size_t k = 0; k != thread_count; ++k)
+	{ m_workers.push_back(std::jthread{[this](){ run_worker(); }}); }
+}
+
+slideproj::utils::thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard lock{m_mutex};
+		m_shutdown = true;
+	}
+	m_work_available.notify_all();
+	m_workers.clear();
+}
+
+void slideproj::utils::thread_pool::run(job& current_job)
+{
+	if(current_job.item_count == 0)
+	{ return; }
+
+	// NOTE: There is nothing to share, so skip the synchronization
+	if(current_job.item_count == 1 || m_workers.empty())
+	{
+		for(size_t k = 0; k != current_job.item_count; ++k)
+		{ current_job.run_item(current_job.object, k); }
+		return;
+	}
+
+	auto const is_foreground = current_job.priority == work_priority::foreground;
+	{
+		std::lock_guard lock{m_mutex};
+		m_jobs.push_back(&current_job);
+		if(is_foreground)
+		{ ++m_foreground_job_count; }
+	}
+	m_work_available.notify_all();
+
+	run_items(current_job, false);
+
+	{
+		std::unique_lock lock{m_mutex};
+		std::erase(m_jobs, &current_job);
+		if(is_foreground)
+		{ --m_foreground_job_count; }
+		m_job_released.wait(lock, [&current_job](){ return current_job.active_workers == 0; });
+	}
+
+	if(current_job.error != nullptr)
+	{ std::rethrow_exception(current_job.error); }
+}
+
+void slideproj::utils::thread_pool::run_items(job& current_job, bool yield_to_foreground)
+{
+	while(!current_job.failed.load(std::memory_order_relaxed))
+	{
+		auto const k = current_job.next_item.fetch_add(1, std::memory_order_relaxed);
+		if(k >= current_job.item_count)
+		{ return; }
+
+		try
+		{ current_job.run_item(current_job.object, k); }
+		catch(...)
+		{
+			std::lock_guard lock{current_job.error_mutex};
+			if(current_job.error == nullptr)
+			{ current_job.error = std::current_exception(); }
+			current_job.failed = true;
+		}
+
+		// NOTE: At least one item is run before yielding, so a worker cannot get stuck switching
+		//       between jobs when the foreground job has no items left
+		if(yield_to_foreground && m_foreground_job_count.load(std::memory_order_relaxed) != 0)
+		{ return; }
+	}
+}
+
+slideproj::utils::thread_pool::job* slideproj::utils::thread_pool::find_job() const
+{
+	// NOTE: Among jobs with the same priority, the oldest one is picked, so it finishes first
+	job* ret = nullptr;
+	for(auto item : m_jobs)
+	{
+		if(!item->has_items_left())
+		{ continue; }
+
+		if(ret == nullptr || item->priority > ret->priority)
+		{ ret = item; }
+	}
+	return ret;
+}
+
+void slideproj::utils::thread_pool::run_worker()
+{
+	std::unique_lock lock{m_mutex};
+	while(true)
+	{
+		job* current_job = nullptr;
+		m_work_available.wait(lock, [this, &current_job](){
+			if(m_shutdown)
+			{ return true; }
+			current_job = find_job();
+			return current_job != nullptr;
+		});
+
+		if(m_shutdown)
+		{ return; }
+
+		++current_job->active_workers;
+		lock.unlock();
+		run_items(*current_job, current_job->priority != work_priority::foreground);
+		lock.lock();
+		--current_job->active_workers;
+		if(current_job->active_workers == 0)
+		{ m_job_released.notify_all(); }
+	}
+}
@@ -0,0 +1,123 @@
+//@	{"dependencies_extra":[{"ref":"./thread_pool.o", "rel":"implementation"}]}
+
+#ifndef SLIDEPROJ_UTILS_THREAD_POOL_HPP
+#define SLIDEPROJ_UTILS_THREAD_POOL_HPP
+
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace slideproj::utils
+{
+	enum class work_priority{background, foreground};
+
+	// A work priority that may change while work is in progress, for example when the user starts
+	// waiting for an image that is being prefetched. The priority is read each time parallel_for
+	// starts a job.
+	class work_priority_source
+	{
+	public:
+		constexpr work_priority_source(work_priority value):
+			m_value{value},
+			m_object{nullptr},
+			m_get{nullptr}
+		{}
+
+		// NOTE: obj must outlive the work that uses it
+		template<class Object>
+		requires(requires(Object const& obj){ {obj()} -> std::same_as<work_priority>; })
+		explicit work_priority_source(Object const& obj):
+			m_value{work_priority::background},
+			m_object{&obj},
+			m_get{[](void const* object) -> work_priority {
+				return (*static_cast<Object const*>(object))();
+			}}
+		{}
+
+		work_priority get() const
+		{ return m_get != nullptr? m_get(m_object) : m_value; }
+
+	private:
+		work_priority m_value;
+		void const* m_object;
+		work_priority (*m_get)(void const*);
+	};
+
+	// A fixed set of threads that help callers of parallel_for. Workers always pick items from the
+	// job with the highest priority, and leave background jobs as soon as foreground work arrives.
+	//
+	// NOTE: The calling thread takes part in its own job, so parallel_for makes progress even when all
+	//       workers are busy, and can be called from within an item.
+	class thread_pool
+	{
+	public:
+		explicit thread_pool(size_t thread_count);
+
+		thread_pool(thread_pool const&) = delete;
+		thread_pool& operator=(thread_pool const&) = delete;
+
+		~thread_pool();
+
+		size_t thread_count() const
+		{ return std::size(m_workers); }
+
+		// Calls func(k) for every k in [0, item_count), and returns when all calls have finished. The
+		// first exception thrown by func is rethrown, after remaining items have been skipped.
+		template<class Callable>
+		void parallel_for(size_t item_count, work_priority_source priority, Callable func)
+		{
+			job current_job{
+				.item_count = item_count,
+				.priority = priority.get(),
+				.object = &func,
+				.run_item = [](void* object, size_t k) {
+					(*static_cast<Callable*>(object))(k);
+				}
+			};
+			run(current_job);
+		}
+
+	private:
+		struct job
+		{
+			size_t item_count;
+			work_priority priority;
+			void* object;
+			void (*run_item)(void* object, size_t k);
+
+			std::atomic<size_t> next_item{0};
+			std::atomic<bool> failed{false};
+			std::mutex error_mutex{};
+			std::exception_ptr error{};
+			// NOTE: Protected by m_mutex
+			size_t active_workers{0};
+
+			bool has_items_left() const
+			{ return !failed.load(std::memory_order_relaxed) && next_item.load(std::memory_order_relaxed) < item_count; }
+		};
+
+		void run(job& current_job);
+
+		void run_items(job& current_job, bool yield_to_foreground);
+
+		job* find_job() const;
+
+		void run_worker();
+
+		std::mutex m_mutex;
+		std::condition_variable m_work_available;
+		std::condition_variable m_job_released;
+		std::vector<job*> m_jobs;
+		std::atomic<size_t> m_foreground_job_count{0};
+		bool m_shutdown{false};
+		// NOTE: Declared last, so workers are joined before anything they use is destroyed
+		std::vector<std::jthread> m_workers;
+	};
+}
+
+#endif
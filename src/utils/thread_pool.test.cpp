@@ -0,0 +1,103 @@
+//@	{"target":{"name":"thread_pool.test"}}
+
+#include "./thread_pool.hpp"
+
+#include "testfwk/testfwk.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+TESTCASE(slideproj_utils_thread_pool_visits_all_items_once)
+{
+	slideproj::utils::thread_pool workers{3};
+	std::vector<std::atomic<int>> visited(1000);
+	workers.parallel_for(std::size(visited), slideproj::utils::work_priority::foreground, [&visited](size_t k){
+		++visited[k];
+	});
+
+	EXPECT_EQ(std::ranges::all_of(visited, [](auto const& item){ return item == 1; }), true);
+}
+
+TESTCASE(slideproj_utils_thread_pool_no_threads)
+{
+	slideproj::utils::thread_pool workers{0};
+	size_t sum = 0;
+	workers.parallel_for(10, slideproj::utils::work_priority::background, [&sum](size_t k){ sum += k; });
+	EXPECT_EQ(sum, 45);
+}
+
+TESTCASE(slideproj_utils_thread_pool_no_items)
+{
+	slideproj::utils::thread_pool workers{2};
+	size_t call_count = 0;
+	workers.parallel_for(0, slideproj::utils::work_priority::foreground, [&call_count](size_t){ ++call_count; });
+	EXPECT_EQ(call_count, 0);
+}
+
+TESTCASE(slideproj_utils_thread_pool_rethrows)
+{
+	slideproj::utils::thread_pool workers{3};
+	std::string message;
+	try
+	{
+		workers.parallel_for(100, slideproj::utils::work_priority::foreground, [](size_t k){
+			if(k == 50)
+			{ throw std::runtime_error{"Error"}; }
+		});
+	}
+	catch(std::runtime_error const& err)
+	{ message = err.what(); }
+
+	EXPECT_EQ(message, "Error");
+}
+
+TESTCASE(slideproj_utils_thread_pool_concurrent_callers)
+{
+	slideproj::utils::thread_pool workers{2};
+	std::vector<std::atomic<int>> visited(4096);
+	{
+		std::jthread background{[&workers, &visited](){
+			workers.parallel_for(std::size(visited)/2, slideproj::utils::work_priority::background, [&visited](size_t k){
+				++visited[k];
+			});
+		}};
+
+		workers.parallel_for(std::size(visited)/2, slideproj::utils::work_priority::foreground, [&visited](size_t k){
+			++visited[k + std::size(visited)/2];
+		});
+	}
+
+	EXPECT_EQ(std::ranges::all_of(visited, [](auto const& item){ return item == 1; }), true);
+}
+
+TESTCASE(slideproj_utils_thread_pool_nested)
+{
+	slideproj::utils::thread_pool workers{2};
+	std::atomic<size_t> call_count{0};
+	workers.parallel_for(8, slideproj::utils::work_priority::foreground, [&workers, &call_count](size_t){
+		workers.parallel_for(8, slideproj::utils::work_priority::foreground, [&call_count](size_t){
+			++call_count;
+		});
+	});
+	EXPECT_EQ(call_count.load(), 64);
+}
+
+TESTCASE(slideproj_utils_thread_pool_work_priority_source)
+{
+	slideproj::utils::work_priority_source const fixed{slideproj::utils::work_priority::foreground};
+	EXPECT_EQ(fixed.get() == slideproj::utils::work_priority::foreground, true);
+
+	std::atomic<slideproj::utils::work_priority> value{slideproj::utils::work_priority::background};
+	auto const get_value = [&value](){ return value.load(); };
+	slideproj::utils::work_priority_source const source{get_value};
+	EXPECT_EQ(source.get() == slideproj::utils::work_priority::background, true);
+	value = slideproj::utils::work_priority::foreground;
+	EXPECT_EQ(source.get() == slideproj::utils::work_priority::foreground, true);
+
+	slideproj::utils::thread_pool workers{2};
+	std::atomic<size_t> sum{0};
+	workers.parallel_for(10, source, [&sum](size_t k){ sum += k; });
+	EXPECT_EQ(sum, 45);
+}
@@ -14,6 +14,10 @@ namespace slideproj::windowing_api
 	struct window_is_closing_event
 	{};
 
+	// Sent when the contents of the window have been lost, and must be drawn again
+	struct window_damaged_event
+	{};
+
 	class typing_keyboard_scancode
 	{
 	public: